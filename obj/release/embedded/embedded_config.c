@@ -0,0 +1,232 @@
+// Generated by tools/embed-config.c from /tmp/tmp.BNsbG2rvKW/config.json - do not edit
+
+#include "router-switch.h"
+
+static const char *const api_keys_0[] = {0};
+static const char *const models_0[] = {"model-1-large", "model-1-small"};
+static const char *const env_names_0[] = {"API_TIMEOUT_MS", "PROVIDER_TAG"};
+static const char *const env_values_0[] = {"600000", "bench 1"};
+static const int key_weights_0[] = {1, 1, 1, 1, 1, 1, 1, 1};
+static const char *const api_key_exports_0[] = {0};
+static const char *const model_exports_0[] = {"export ANTHROPIC_MODEL=model-1-large\n", "export ANTHROPIC_MODEL=model-1-small\n"};
+
+static const char *const api_keys_1[] = {0};
+static const char *const models_1[] = {"model-2-large", "model-2-small"};
+static const char *const env_names_1[] = {"API_TIMEOUT_MS", "PROVIDER_TAG"};
+static const char *const env_values_1[] = {"600000", "bench 2"};
+static const int key_weights_1[] = {1, 1, 1, 1, 1, 1, 1, 1};
+static const char *const api_key_exports_1[] = {0};
+static const char *const model_exports_1[] = {"export ANTHROPIC_MODEL=model-2-large\n", "export ANTHROPIC_MODEL=model-2-small\n"};
+
+static const char *const api_keys_2[] = {0};
+static const char *const models_2[] = {"model-3-large", "model-3-small"};
+static const char *const env_names_2[] = {"API_TIMEOUT_MS", "PROVIDER_TAG"};
+static const char *const env_values_2[] = {"600000", "bench 3"};
+static const int key_weights_2[] = {1, 1, 1, 1, 1, 1, 1, 1};
+static const char *const api_key_exports_2[] = {0};
+static const char *const model_exports_2[] = {"export ANTHROPIC_MODEL=model-3-large\n", "export ANTHROPIC_MODEL=model-3-small\n"};
+
+static const char *const api_keys_3[] = {0};
+static const char *const models_3[] = {"model-4-large", "model-4-small"};
+static const char *const env_names_3[] = {"API_TIMEOUT_MS", "PROVIDER_TAG"};
+static const char *const env_values_3[] = {"600000", "bench 4"};
+static const int key_weights_3[] = {1, 1, 1, 1, 1, 1, 1, 1};
+static const char *const api_key_exports_3[] = {0};
+static const char *const model_exports_3[] = {"export ANTHROPIC_MODEL=model-4-large\n", "export ANTHROPIC_MODEL=model-4-small\n"};
+
+static const char *const api_keys_4[] = {0};
+static const char *const models_4[] = {"model-5-large", "model-5-small"};
+static const char *const env_names_4[] = {"API_TIMEOUT_MS", "PROVIDER_TAG"};
+static const char *const env_values_4[] = {"600000", "bench 5"};
+static const int key_weights_4[] = {1, 1, 1, 1, 1, 1, 1, 1};
+static const char *const api_key_exports_4[] = {0};
+static const char *const model_exports_4[] = {"export ANTHROPIC_MODEL=model-5-large\n", "export ANTHROPIC_MODEL=model-5-small\n"};
+
+static const char *const api_keys_5[] = {0};
+static const char *const models_5[] = {"model-6-large", "model-6-small"};
+static const char *const env_names_5[] = {"API_TIMEOUT_MS", "PROVIDER_TAG"};
+static const char *const env_values_5[] = {"600000", "bench 6"};
+static const int key_weights_5[] = {1, 1, 1, 1, 1, 1, 1, 1};
+static const char *const api_key_exports_5[] = {0};
+static const char *const model_exports_5[] = {"export ANTHROPIC_MODEL=model-6-large\n", "export ANTHROPIC_MODEL=model-6-small\n"};
+
+static const char *const api_keys_6[] = {0};
+static const char *const models_6[] = {"model-7-large", "model-7-small"};
+static const char *const env_names_6[] = {"API_TIMEOUT_MS", "PROVIDER_TAG"};
+static const char *const env_values_6[] = {"600000", "bench 7"};
+static const int key_weights_6[] = {1, 1, 1, 1, 1, 1, 1, 1};
+static const char *const api_key_exports_6[] = {0};
+static const char *const model_exports_6[] = {"export ANTHROPIC_MODEL=model-7-large\n", "export ANTHROPIC_MODEL=model-7-small\n"};
+
+static const char *const api_keys_7[] = {0};
+static const char *const models_7[] = {"model-8-large", "model-8-small"};
+static const char *const env_names_7[] = {"API_TIMEOUT_MS", "PROVIDER_TAG"};
+static const char *const env_values_7[] = {"600000", "bench 8"};
+static const int key_weights_7[] = {1, 1, 1, 1, 1, 1, 1, 1};
+static const char *const api_key_exports_7[] = {0};
+static const char *const model_exports_7[] = {"export ANTHROPIC_MODEL=model-8-large\n", "export ANTHROPIC_MODEL=model-8-small\n"};
+
+static const char *const api_keys_8[] = {0};
+static const char *const models_8[] = {"model-9-large", "model-9-small"};
+static const char *const env_names_8[] = {"API_TIMEOUT_MS", "PROVIDER_TAG"};
+static const char *const env_values_8[] = {"600000", "bench 9"};
+static const int key_weights_8[] = {1, 1, 1, 1, 1, 1, 1, 1};
+static const char *const api_key_exports_8[] = {0};
+static const char *const model_exports_8[] = {"export ANTHROPIC_MODEL=model-9-large\n", "export ANTHROPIC_MODEL=model-9-small\n"};
+
+static const char *const api_keys_9[] = {0};
+static const char *const models_9[] = {"model-10-large", "model-10-small"};
+static const char *const env_names_9[] = {"API_TIMEOUT_MS", "PROVIDER_TAG"};
+static const char *const env_values_9[] = {"600000", "bench 10"};
+static const int key_weights_9[] = {1, 1, 1, 1, 1, 1, 1, 1};
+static const char *const api_key_exports_9[] = {0};
+static const char *const model_exports_9[] = {"export ANTHROPIC_MODEL=model-10-large\n", "export ANTHROPIC_MODEL=model-10-small\n"};
+
+static const EmbeddedProvider providers[] = {
+    {
+        "provider1",
+        "Benchmark provider 1",
+        "https://api.provider1.example.com/anthropic",
+        "sk-bench-1-0123456789abcdef",
+        api_keys_0, key_weights_0, 0, KEY_POLICY_ROUND_ROBIN,
+        models_0, 2,
+        env_names_0, env_values_0, 2,
+        "unset ANTHROPIC_BASE_URL\nunset ANTHROPIC_AUTH_TOKEN\nunset ANTHROPIC_MODEL\nunset API_TIMEOUT_MS\nunset PROVIDER_TAG\nunset ROUTERSWITCH_CURRENT_PROVIDER\n",
+        "export ANTHROPIC_BASE_URL=https://api.provider1.example.com/anthropic\n",
+        "export ANTHROPIC_AUTH_TOKEN=sk-bench-1-0123456789abcdef\n",
+        api_key_exports_0, model_exports_0,
+        "export API_TIMEOUT_MS=600000\nexport PROVIDER_TAG='bench 1'\nexport ROUTERSWITCH_CURRENT_PROVIDER=provider1\n"
+    },
+    {
+        "provider2",
+        "Benchmark provider 2",
+        "https://api.provider2.example.com/anthropic",
+        "sk-bench-2-0123456789abcdef",
+        api_keys_1, key_weights_1, 0, KEY_POLICY_ROUND_ROBIN,
+        models_1, 2,
+        env_names_1, env_values_1, 2,
+        "unset ANTHROPIC_BASE_URL\nunset ANTHROPIC_AUTH_TOKEN\nunset ANTHROPIC_MODEL\nunset API_TIMEOUT_MS\nunset PROVIDER_TAG\nunset ROUTERSWITCH_CURRENT_PROVIDER\n",
+        "export ANTHROPIC_BASE_URL=https://api.provider2.example.com/anthropic\n",
+        "export ANTHROPIC_AUTH_TOKEN=sk-bench-2-0123456789abcdef\n",
+        api_key_exports_1, model_exports_1,
+        "export API_TIMEOUT_MS=600000\nexport PROVIDER_TAG='bench 2'\nexport ROUTERSWITCH_CURRENT_PROVIDER=provider2\n"
+    },
+    {
+        "provider3",
+        "Benchmark provider 3",
+        "https://api.provider3.example.com/anthropic",
+        "sk-bench-3-0123456789abcdef",
+        api_keys_2, key_weights_2, 0, KEY_POLICY_ROUND_ROBIN,
+        models_2, 2,
+        env_names_2, env_values_2, 2,
+        "unset ANTHROPIC_BASE_URL\nunset ANTHROPIC_AUTH_TOKEN\nunset ANTHROPIC_MODEL\nunset API_TIMEOUT_MS\nunset PROVIDER_TAG\nunset ROUTERSWITCH_CURRENT_PROVIDER\n",
+        "export ANTHROPIC_BASE_URL=https://api.provider3.example.com/anthropic\n",
+        "export ANTHROPIC_AUTH_TOKEN=sk-bench-3-0123456789abcdef\n",
+        api_key_exports_2, model_exports_2,
+        "export API_TIMEOUT_MS=600000\nexport PROVIDER_TAG='bench 3'\nexport ROUTERSWITCH_CURRENT_PROVIDER=provider3\n"
+    },
+    {
+        "provider4",
+        "Benchmark provider 4",
+        "https://api.provider4.example.com/anthropic",
+        "sk-bench-4-0123456789abcdef",
+        api_keys_3, key_weights_3, 0, KEY_POLICY_ROUND_ROBIN,
+        models_3, 2,
+        env_names_3, env_values_3, 2,
+        "unset ANTHROPIC_BASE_URL\nunset ANTHROPIC_AUTH_TOKEN\nunset ANTHROPIC_MODEL\nunset API_TIMEOUT_MS\nunset PROVIDER_TAG\nunset ROUTERSWITCH_CURRENT_PROVIDER\n",
+        "export ANTHROPIC_BASE_URL=https://api.provider4.example.com/anthropic\n",
+        "export ANTHROPIC_AUTH_TOKEN=sk-bench-4-0123456789abcdef\n",
+        api_key_exports_3, model_exports_3,
+        "export API_TIMEOUT_MS=600000\nexport PROVIDER_TAG='bench 4'\nexport ROUTERSWITCH_CURRENT_PROVIDER=provider4\n"
+    },
+    {
+        "provider5",
+        "Benchmark provider 5",
+        "https://api.provider5.example.com/anthropic",
+        "sk-bench-5-0123456789abcdef",
+        api_keys_4, key_weights_4, 0, KEY_POLICY_ROUND_ROBIN,
+        models_4, 2,
+        env_names_4, env_values_4, 2,
+        "unset ANTHROPIC_BASE_URL\nunset ANTHROPIC_AUTH_TOKEN\nunset ANTHROPIC_MODEL\nunset API_TIMEOUT_MS\nunset PROVIDER_TAG\nunset ROUTERSWITCH_CURRENT_PROVIDER\n",
+        "export ANTHROPIC_BASE_URL=https://api.provider5.example.com/anthropic\n",
+        "export ANTHROPIC_AUTH_TOKEN=sk-bench-5-0123456789abcdef\n",
+        api_key_exports_4, model_exports_4,
+        "export API_TIMEOUT_MS=600000\nexport PROVIDER_TAG='bench 5'\nexport ROUTERSWITCH_CURRENT_PROVIDER=provider5\n"
+    },
+    {
+        "provider6",
+        "Benchmark provider 6",
+        "https://api.provider6.example.com/anthropic",
+        "sk-bench-6-0123456789abcdef",
+        api_keys_5, key_weights_5, 0, KEY_POLICY_ROUND_ROBIN,
+        models_5, 2,
+        env_names_5, env_values_5, 2,
+        "unset ANTHROPIC_BASE_URL\nunset ANTHROPIC_AUTH_TOKEN\nunset ANTHROPIC_MODEL\nunset API_TIMEOUT_MS\nunset PROVIDER_TAG\nunset ROUTERSWITCH_CURRENT_PROVIDER\n",
+        "export ANTHROPIC_BASE_URL=https://api.provider6.example.com/anthropic\n",
+        "export ANTHROPIC_AUTH_TOKEN=sk-bench-6-0123456789abcdef\n",
+        api_key_exports_5, model_exports_5,
+        "export API_TIMEOUT_MS=600000\nexport PROVIDER_TAG='bench 6'\nexport ROUTERSWITCH_CURRENT_PROVIDER=provider6\n"
+    },
+    {
+        "provider7",
+        "Benchmark provider 7",
+        "https://api.provider7.example.com/anthropic",
+        "sk-bench-7-0123456789abcdef",
+        api_keys_6, key_weights_6, 0, KEY_POLICY_ROUND_ROBIN,
+        models_6, 2,
+        env_names_6, env_values_6, 2,
+        "unset ANTHROPIC_BASE_URL\nunset ANTHROPIC_AUTH_TOKEN\nunset ANTHROPIC_MODEL\nunset API_TIMEOUT_MS\nunset PROVIDER_TAG\nunset ROUTERSWITCH_CURRENT_PROVIDER\n",
+        "export ANTHROPIC_BASE_URL=https://api.provider7.example.com/anthropic\n",
+        "export ANTHROPIC_AUTH_TOKEN=sk-bench-7-0123456789abcdef\n",
+        api_key_exports_6, model_exports_6,
+        "export API_TIMEOUT_MS=600000\nexport PROVIDER_TAG='bench 7'\nexport ROUTERSWITCH_CURRENT_PROVIDER=provider7\n"
+    },
+    {
+        "provider8",
+        "Benchmark provider 8",
+        "https://api.provider8.example.com/anthropic",
+        "sk-bench-8-0123456789abcdef",
+        api_keys_7, key_weights_7, 0, KEY_POLICY_ROUND_ROBIN,
+        models_7, 2,
+        env_names_7, env_values_7, 2,
+        "unset ANTHROPIC_BASE_URL\nunset ANTHROPIC_AUTH_TOKEN\nunset ANTHROPIC_MODEL\nunset API_TIMEOUT_MS\nunset PROVIDER_TAG\nunset ROUTERSWITCH_CURRENT_PROVIDER\n",
+        "export ANTHROPIC_BASE_URL=https://api.provider8.example.com/anthropic\n",
+        "export ANTHROPIC_AUTH_TOKEN=sk-bench-8-0123456789abcdef\n",
+        api_key_exports_7, model_exports_7,
+        "export API_TIMEOUT_MS=600000\nexport PROVIDER_TAG='bench 8'\nexport ROUTERSWITCH_CURRENT_PROVIDER=provider8\n"
+    },
+    {
+        "provider9",
+        "Benchmark provider 9",
+        "https://api.provider9.example.com/anthropic",
+        "sk-bench-9-0123456789abcdef",
+        api_keys_8, key_weights_8, 0, KEY_POLICY_ROUND_ROBIN,
+        models_8, 2,
+        env_names_8, env_values_8, 2,
+        "unset ANTHROPIC_BASE_URL\nunset ANTHROPIC_AUTH_TOKEN\nunset ANTHROPIC_MODEL\nunset API_TIMEOUT_MS\nunset PROVIDER_TAG\nunset ROUTERSWITCH_CURRENT_PROVIDER\n",
+        "export ANTHROPIC_BASE_URL=https://api.provider9.example.com/anthropic\n",
+        "export ANTHROPIC_AUTH_TOKEN=sk-bench-9-0123456789abcdef\n",
+        api_key_exports_8, model_exports_8,
+        "export API_TIMEOUT_MS=600000\nexport PROVIDER_TAG='bench 9'\nexport ROUTERSWITCH_CURRENT_PROVIDER=provider9\n"
+    },
+    {
+        "provider10",
+        "Benchmark provider 10",
+        "https://api.provider10.example.com/anthropic",
+        "sk-bench-10-0123456789abcdef",
+        api_keys_9, key_weights_9, 0, KEY_POLICY_ROUND_ROBIN,
+        models_9, 2,
+        env_names_9, env_values_9, 2,
+        "unset ANTHROPIC_BASE_URL\nunset ANTHROPIC_AUTH_TOKEN\nunset ANTHROPIC_MODEL\nunset API_TIMEOUT_MS\nunset PROVIDER_TAG\nunset ROUTERSWITCH_CURRENT_PROVIDER\n",
+        "export ANTHROPIC_BASE_URL=https://api.provider10.example.com/anthropic\n",
+        "export ANTHROPIC_AUTH_TOKEN=sk-bench-10-0123456789abcdef\n",
+        api_key_exports_9, model_exports_9,
+        "export API_TIMEOUT_MS=600000\nexport PROVIDER_TAG='bench 10'\nexport ROUTERSWITCH_CURRENT_PROVIDER=provider10\n"
+    },
+};
+
+static const int16_t provider_index[] = {-1, -1, -1, -1, -1, 9, -1, -1, -1, -1, 1, 4, 7, -1, -1, -1, -1, 6, -1, -1, -1, -1, -1, 0, 3, -1, -1, -1, -1, 2, 5, 8};
+
+const EmbeddedConfig embedded_config = {
+    providers, 10, provider_index, 32, 0u, "/tmp/tmp.BNsbG2rvKW/config.json"
+};
@@ -0,0 +1,158 @@
+#include "router-switch.h"
+
+#define SWITCH_STATE_FILE "switch.state"
+#define SWITCH_STATE_MAGIC 0x57535352u // "RSSW"
+#define SWITCH_STATE_VERSION 1
+#define MAX_SEQLOCK_SPINS 1000000
+
+static SwitchState* attach_switch_state(void) {
+    SwitchState *state = map_state_file(SWITCH_STATE_FILE, sizeof(SwitchState));
+    if (!state) return NULL;
+
+    uint32_t expected = 0;
+    if (__atomic_load_n(&state->magic, __ATOMIC_ACQUIRE) == 0) {
+        state->version = SWITCH_STATE_VERSION;
+        __atomic_compare_exchange_n(&state->magic, &expected, SWITCH_STATE_MAGIC, 0,
+                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+    }
+
+    if (__atomic_load_n(&state->magic, __ATOMIC_ACQUIRE) != SWITCH_STATE_MAGIC ||
+        state->version != SWITCH_STATE_VERSION) {
+        unmap_state_file(state, sizeof(SwitchState));
+        return NULL;
+    }
+    return state;
+}
+
+// Publish the selection under the seqlock and bump the generation. Writers
+// serialize with flock on the state file, so the generation text always moves
+// forward and readers never see two writers inside the same sequence.
+int publish_global_switch(const CliOptions *options) {
+    SwitchState *state = attach_switch_state();
+    if (!state) {
+        fprintf(stderr, "Error: Failed to open global switch state\n");
+        return 1;
+    }
+
+    // Record an absolute config path, other shells run from other directories
+    char config_path[MAX_CONFIG_PATH] = "";
+    const char *source = resolve_config_path(options);
+    if (source && !realpath(source, config_path)) {
+        snprintf(config_path, sizeof(config_path), "%s", source);
+    }
+
+    int lock_fd = lock_state_file(SWITCH_STATE_FILE);
+    if (lock_fd < 0) {
+        fprintf(stderr, "Error: Failed to lock global switch state\n");
+        unmap_state_file(state, sizeof(SwitchState));
+        return 1;
+    }
+
+    // Odd only if a writer died mid-write; holding the lock, reuse its sequence
+    uint64_t sequence = __atomic_load_n(&state->sequence, __ATOMIC_RELAXED) | 1;
+    __atomic_store_n(&state->sequence, sequence, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    strncpy(state->provider, options->provider, MAX_PROVIDER_NAME - 1);
+    state->provider[MAX_PROVIDER_NAME - 1] = '\0';
+    strncpy(state->model, options->model, MAX_MODEL_NAME - 1);
+    state->model[MAX_MODEL_NAME - 1] = '\0';
+    memcpy(state->config_path, config_path, sizeof(state->config_path));
+
+    uint64_t generation = state->generation + 1;
+    state->generation = generation;
+    snprintf(state->generation_text, sizeof(state->generation_text), "%020llu\n",
+             (unsigned long long)generation);
+
+    __atomic_store_n(&state->sequence, sequence + 1, __ATOMIC_RELEASE);
+    close(lock_fd);
+    unmap_state_file(state, sizeof(SwitchState));
+
+    // This shell is already up to date; keep its prompt hook from re-applying
+    printf("__router_switch_gen=%020llu\n", (unsigned long long)generation);
+    return 0;
+}
+
+// Copy the published selection; returns 0 if nothing was ever published
+static int read_switch_state(SwitchState *out) {
+    SwitchState *state = attach_switch_state();
+    if (!state) return 0;
+
+    int found = 0;
+    for (int attempt = 0; attempt < MAX_SEQLOCK_SPINS; attempt++) {
+        uint64_t before = __atomic_load_n(&state->sequence, __ATOMIC_ACQUIRE);
+        if (before & 1) continue;
+
+        memcpy(out, state, sizeof(SwitchState));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(&state->sequence, __ATOMIC_RELAXED) == before) {
+            found = out->generation > 0;
+            break;
+        }
+    }
+
+    unmap_state_file(state, sizeof(SwitchState));
+    out->provider[MAX_PROVIDER_NAME - 1] = '\0';
+    out->model[MAX_MODEL_NAME - 1] = '\0';
+    out->config_path[MAX_CONFIG_PATH - 1] = '\0';
+    return found;
+}
+
+// Output the switch published by the last --global run
+int run_sync_command(const CliOptions *options, uint64_t start_us) {
+    static SwitchState state;
+    static Config config;
+
+    if (!read_switch_state(&state)) {
+        return 0;
+    }
+
+    const char *config_path = strlen(options->config_path) > 0 ? options->config_path :
+                              (state.config_path[0] ? state.config_path : resolve_config_path(options));
+    const char *model = state.model[0] ? state.model : NULL;
+
+    if (!load_config(config_path, &config) ||
+        !validate_provider_and_model(&config, state.provider, model) ||
+        !switch_provider_environment(&config, state.provider, model, options->verbose)) {
+        return 1;
+    }
+
+    ProviderConfig *provider = find_provider(&config, state.provider);
+    record_switch_event(state.provider, model ? model :
+                        (provider->model_count > 0 ? provider->models[0] : NULL), start_us);
+
+    printf("__router_switch_gen=%020llu\n", (unsigned long long)state.generation);
+    return 0;
+}
+
+// Prompt hook for the shell wrapper. The common no-change path is one `read`
+// of the state file's first line and a string comparison, all builtins.
+void print_sync_hook(void) {
+    char path[MAX_CONFIG_PATH];
+    if (!resolve_state_path(SWITCH_STATE_FILE, path, sizeof(path))) {
+        return;
+    }
+
+    char *escaped_path = shell_escape(path);
+    if (!escaped_path) return;
+
+    printf("# Apply switches made with --global in other shells at the next prompt\n");
+    printf("_router_switch_precmd() {\n");
+    printf("    local gen\n");
+    printf("    { IFS= read -r gen < %s; } 2>/dev/null || return 0\n", escaped_path);
+    printf("    [ \"$gen\" = \"${__router_switch_gen:-}\" ] && return 0\n");
+    printf("    __router_switch_gen=$gen\n");
+    printf("    router-switch sync\n");
+    printf("}\n");
+    printf("if [ -n \"$ZSH_VERSION\" ]; then\n");
+    printf("    autoload -Uz add-zsh-hook 2>/dev/null && add-zsh-hook precmd _router_switch_precmd\n");
+    printf("elif [ -n \"$BASH_VERSION\" ]; then\n");
+    printf("    case \";${PROMPT_COMMAND:-};\" in\n");
+    printf("        *\";_router_switch_precmd;\"*) ;;\n");
+    printf("        *) PROMPT_COMMAND=\"_router_switch_precmd${PROMPT_COMMAND:+;$PROMPT_COMMAND}\" ;;\n");
+    printf("    esac\n");
+    printf("fi\n\n");
+
+    free(escaped_path);
+}
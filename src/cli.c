@@ -1,4 +1,5 @@
 #include "router-switch.h"
+#include <errno.h>
 
 void parse_command_line_args(int argc, char *argv[], CliOptions *options) {
     int opt;
@@ -11,13 +12,16 @@ void parse_command_line_args(int argc, char *argv[], CliOptions *options) {
         {"version",  no_argument,       0, 'V'},
         {"verbose",  no_argument,       0, 'v'},
         {"install",  no_argument,       0, 'i'},
+        {"global",   no_argument,       0, 'g'},
+        {"shared",   no_argument,       0, 's'},
         {0, 0, 0, 0}
     };
 
     // Reset options
     memset(options, 0, sizeof(CliOptions));
 
-    while ((opt = getopt_long(argc, argv, "p:m:c:hvVi", long_options, NULL)) != -1) {
+    // Stop at the first non-option argument so subcommands can parse their own options
+    while ((opt = getopt_long(argc, argv, "+p:m:c:hvVigs", long_options, NULL)) != -1) {
         switch (opt) {
             case 'p':
                 strncpy(options->provider, optarg, MAX_PROVIDER_NAME - 1);
@@ -43,6 +47,12 @@ void parse_command_line_args(int argc, char *argv[], CliOptions *options) {
             case 'i':
                 options->install = 1;
                 break;
+            case 'g':
+                options->global = 1;
+                break;
+            case 's':
+                options->shared = 1;
+                break;
             case '?':
                 fprintf(stderr, "Unknown option. Use --help for usage information.\n");
                 exit(1);
@@ -51,6 +61,52 @@ void parse_command_line_args(int argc, char *argv[], CliOptions *options) {
                 exit(1);
         }
     }
+
+    // Remaining arguments select a subcommand (e.g. "stats")
+    if (optind < argc) {
+        strncpy(options->command, argv[optind], MAX_COMMAND_NAME - 1);
+        options->command[MAX_COMMAND_NAME - 1] = '\0';
+        options->command_argc = argc - optind;
+        options->command_argv = argv + optind;
+    }
+}
+
+// Prepare getopt_long for parsing a subcommand's own argument vector
+void reset_option_parser(void) {
+#ifdef __GLIBC__
+    optind = 0;
+#else
+    optreset = 1;
+    optind = 1;
+#endif
+}
+
+// Parse a whole decimal argument; returns 0 unless it is a number in [min, max]
+int parse_long_argument(const char *text, long min, long max, long *value) {
+    char *end;
+    errno = 0;
+    *value = strtol(text, &end, 10);
+    return end != text && *end == '\0' && errno == 0 && *value >= min && *value <= max;
+}
+
+// Same for a decimal fraction such as a rate or a percentile
+int parse_double_argument(const char *text, double min, double max, double *value) {
+    char *end;
+    errno = 0;
+    *value = strtod(text, &end);
+    return end != text && *end == '\0' && errno == 0 && *value >= min && *value <= max;
+}
+
+// Append a -p argument to a subcommand's provider list; returns 0 once it is full
+int add_provider_argument(char providers[][MAX_PROVIDER_NAME], int *provider_count, const char *name) {
+    if (*provider_count >= MAX_PROVIDERS) {
+        fprintf(stderr, "Error: At most %d providers can be selected\n", MAX_PROVIDERS);
+        return 0;
+    }
+    strncpy(providers[*provider_count], name, MAX_PROVIDER_NAME - 1);
+    providers[*provider_count][MAX_PROVIDER_NAME - 1] = '\0';
+    (*provider_count)++;
+    return 1;
 }
 
 void display_help(void) {
@@ -59,20 +115,39 @@ void display_help(void) {
     printf("A CLI tool to switch between AI providers and models for Claude Code\n\n");
     printf("This tool outputs shell commands to set environment variables.\n");
     printf("Use eval to execute the commands in your shell: eval $(router-switch -p provider)\n\n");
-    printf("Usage: router-switch [options]\n\n");
+    printf("Usage: router-switch [options]\n");
+    printf("       router-switch <command>\n\n");
     printf("Options:\n");
     printf("  -p, --provider <provider>  Specify AI provider from config.json\n");
     printf("  -m, --model <model>        Specify AI model for the provider\n");
     printf("  -c, --config <path>        Specify custom configuration file path\n");
     printf("  -v, --verbose              Show detailed output to stderr\n");
     printf("  -i, --install              Generate shell wrapper function for easy usage\n");
+    printf("  -g, --global               Also switch every other shell (applied at its next prompt)\n");
+    printf("  -s, --shared               Read the config from shared memory, publishing it if stale\n");
     printf("  -V, --version              Display version information\n");
     printf("  -h, --help                 Display this help message\n");
+    printf("\nCommands:\n");
+    printf("  stats                      Show provider/model usage and switch latency\n");
+    printf("  cooldown -p <provider>     Skip a throttled API key for a while\n");
+    printf("           [--key <n>] [--seconds <s>]  (default: key in $ANTHROPIC_AUTH_TOKEN, 60s)\n");
+    printf("  sync                       Apply the last --global switch (used by the prompt hook)\n");
+    printf("  publish [--unlink]         Publish the parsed config to shared memory (or remove it)\n");
+    printf("  mock-server [-p <provider>]...  Serve providers locally for offline testing\n");
+    printf("           [--port <n>] [--bind <addr>] [--latency-ms <n>] [--jitter-ms <n>]\n");
+    printf("           [--tail-rate <0..1>] [--tail-ms <n>] [--error-rate <0..1>]\n");
+    printf("           [--stream] [--chunks <n>] [--chunk-interval-ms <n>]\n");
+    printf("  replay [-p <provider>]... <log.jsonl>  Replay recorded requests, compare latency\n");
+    printf("           [--rate <req/s>] [--speed <factor>] [--timeout-ms <n>] [--keep-model]\n");
+    printf("  forward [-p <provider>]...  Proxy requests to a provider set, hedging slow ones\n");
+    printf("           [--port <n>] [--bind <addr>] [--hedge-delay-ms <n>] [--hedge-percentile <p>]\n");
+    printf("           [--max-attempts <n>] [--holdout <0..1>] [--timeout-ms <n>] [--keep-model]\n");
     printf("\nExamples:\n");
     printf("  eval $(router-switch --provider deepseek --model deepseek-chat)\n");
     printf("  eval $(router-switch -p glm)                                      # Simple\n");
     printf("  router-switch --install >> ~/.zshrc && source ~/.zshrc            # Install wrapper\n");
     printf("  router-switch --config /path/to/custom-config.json\n");
+    printf("  router-switch stats                                               # Usage statistics\n");
     printf("\nInstallation:\n");
     printf("  Run 'router-switch --install' to generate a shell wrapper function.\n");
     printf("  Add the output to your ~/.zshrc or ~/.bashrc, then reload your shell.\n");
@@ -1,6 +1,25 @@
 #include "router-switch.h"
 
+// Config path for a run: --config if given, otherwise the built-in tables
+// (embedded builds, signalled by NULL) or config.json
+const char* resolve_config_path(const CliOptions *options) {
+    if (strlen(options->config_path) > 0) {
+        return options->config_path;
+    }
+#ifdef ROUTER_SWITCH_EMBEDDED
+    return NULL;
+#else
+    return DEFAULT_CONFIG_PATH;
+#endif
+}
+
 int load_config(const char *config_path, Config *config) {
+#ifdef ROUTER_SWITCH_EMBEDDED
+    if (config_path == NULL) {
+        load_embedded_config(config);
+        return 1;
+    }
+#endif
     if (!parse_config_file(config_path, config)) {
         fprintf(stderr, "Failed to load config file '%s'\n", config_path);
         return 0;
@@ -8,6 +27,15 @@ int load_config(const char *config_path, Config *config) {
     return 1;
 }
 
+// FNV-1a over the provider name, seeded for the embedded perfect hash
+uint32_t hash_provider_name(const char *name, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (const char *p = name; *p; p++) {
+        hash = (hash ^ (uint8_t)*p) * 16777619u;
+    }
+    return hash;
+}
+
 ProviderConfig* find_provider(const Config *config, const char *provider_name) {
     for (int i = 0; i < config->provider_count; i++) {
         if (strcmp(config->providers[i].name, provider_name) == 0) {
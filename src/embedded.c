@@ -0,0 +1,113 @@
+#include "router-switch.h"
+
+#ifdef ROUTER_SWITCH_EMBEDDED
+
+// Perfect hash lookup into the generated provider tables
+const EmbeddedProvider* find_embedded_provider(const char *provider_name) {
+    if (embedded_config.index_size == 0) {
+        return NULL;
+    }
+
+    uint32_t slot = hash_provider_name(provider_name, embedded_config.hash_seed) &
+                    (embedded_config.index_size - 1);
+    int index = embedded_config.index[slot];
+    if (index < 0 || strcmp(embedded_config.providers[index].name, provider_name) != 0) {
+        return NULL;
+    }
+    return &embedded_config.providers[index];
+}
+
+// Materialize the built-in tables as a regular Config for the non-switch paths
+void load_embedded_config(Config *config) {
+    memset(config, 0, sizeof(Config));
+
+    for (int i = 0; i < embedded_config.provider_count && i < MAX_PROVIDERS; i++) {
+        const EmbeddedProvider *source = &embedded_config.providers[i];
+        ProviderConfig *provider = &config->providers[i];
+
+        strncpy(provider->name, source->name, MAX_PROVIDER_NAME - 1);
+        strncpy(provider->description, source->description, sizeof(provider->description) - 1);
+        strncpy(provider->base_url, source->base_url, sizeof(provider->base_url) - 1);
+        strncpy(provider->api_key, source->api_key, sizeof(provider->api_key) - 1);
+
+        provider->api_key_count = source->api_key_count;
+        provider->key_policy = source->key_policy;
+        for (int k = 0; k < MAX_API_KEYS; k++) {
+            provider->key_weights[k] = 1;
+        }
+        for (int k = 0; k < source->api_key_count; k++) {
+            strncpy(provider->api_keys[k], source->api_keys[k], sizeof(provider->api_keys[k]) - 1);
+            provider->key_weights[k] = source->key_weights[k];
+        }
+
+        provider->model_count = source->model_count;
+        for (int m = 0; m < source->model_count; m++) {
+            strncpy(provider->models[m], source->models[m], MAX_MODEL_NAME - 1);
+        }
+
+        provider->env_count = source->env_count;
+        for (int e = 0; e < source->env_count; e++) {
+            strncpy(provider->env_names[e], source->env_names[e], MAX_ENV_VAR_NAME - 1);
+            strncpy(provider->env_values[e], source->env_values[e], MAX_ENV_VAR_VALUE - 1);
+        }
+    }
+    config->provider_count = embedded_config.provider_count;
+}
+
+// Switch using the pre-escaped export strings. Produces exactly the output of
+// clear_provider_environment + apply_provider_environment.
+int embedded_switch(const CliOptions *options, uint64_t start_us) {
+    const EmbeddedProvider *provider = find_embedded_provider(options->provider);
+    const char *model_name = strlen(options->model) > 0 ? options->model : NULL;
+    int model_index = 0;
+
+    if (provider && model_name && provider->model_count > 0) {
+        while (model_index < provider->model_count &&
+               strcmp(provider->models[model_index], model_name) != 0) {
+            model_index++;
+        }
+        if (model_index == provider->model_count) {
+            provider = NULL;
+        }
+    }
+
+    // Error path: reuse the regular validation messages
+    if (!provider) {
+        Config *config = malloc(sizeof(Config));
+        if (config) {
+            load_embedded_config(config);
+            validate_provider_and_model(config, options->provider, model_name);
+            free(config);
+        }
+        return 1;
+    }
+
+    const char *current_provider = getenv("ROUTERSWITCH_CURRENT_PROVIDER");
+    if (current_provider) {
+        const EmbeddedProvider *previous = find_embedded_provider(current_provider);
+        if (previous) {
+            fputs(previous->unset_script, stdout);
+        } else if (options->verbose) {
+            fprintf(stderr, "Warning: Failed to clear environment for provider '%s'\n", current_provider);
+        }
+    }
+
+    fputs(provider->base_url_export, stdout);
+    if (provider->api_key_count > 0) {
+        int key = select_key_index(provider->name, provider->api_key_count,
+                                   provider->key_policy, provider->key_weights);
+        fputs(provider->api_key_exports[key], stdout);
+    } else {
+        fputs(provider->api_key_export, stdout);
+    }
+    if (provider->model_count > 0) {
+        fputs(provider->model_exports[model_index], stdout);
+    }
+    fputs(provider->env_exports, stdout);
+
+    record_switch_event(provider->name, model_name ? model_name :
+                        (provider->model_count > 0 ? provider->models[0] : NULL), start_us);
+    return 0;
+}
+
+#endif // ROUTER_SWITCH_EMBEDDED
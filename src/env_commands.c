@@ -2,7 +2,7 @@
 #include <errno.h>
 
 // Shell escaping utility function
-static char* shell_escape(const char* value) {
+char* shell_escape(const char* value) {
     if (!value) return NULL;
 
     // Check if value needs escaping
@@ -113,7 +113,12 @@ int apply_provider_environment(const Config *config, const char *provider_name,
 
     // Set provider base configuration
     print_export_command("ANTHROPIC_BASE_URL", provider->base_url);
-    print_export_command("ANTHROPIC_AUTH_TOKEN", provider->api_key);
+    if (provider->api_key_count > 0) {
+        // Spread sessions across the provider's key pool
+        print_export_command("ANTHROPIC_AUTH_TOKEN", provider->api_keys[select_api_key(provider)]);
+    } else {
+        print_export_command("ANTHROPIC_AUTH_TOKEN", provider->api_key);
+    }
 
     // Set model if applicable
     if (provider->model_count > 0) {
@@ -152,6 +157,29 @@ int apply_provider_environment(const Config *config, const char *provider_name,
     return 1;
 }
 
+// Clear the current provider (if any) and apply the new one
+int switch_provider_environment(const Config *config, const char *provider_name, const char *model_name, int verbose) {
+    char *current_provider = get_current_provider();
+
+    // Clear environment variables for current provider (if any)
+    if (current_provider != NULL) {
+        if (!clear_provider_environment(config, current_provider)) {
+            if (verbose) {
+                fprintf(stderr, "Warning: Failed to clear environment for provider '%s'\n", current_provider);
+            }
+            // Don't return here, continue with setting new provider
+        }
+        free(current_provider);
+    }
+
+    // Set environment variables for new provider
+    if (!apply_provider_environment(config, provider_name, model_name)) {
+        fprintf(stderr, "Error: Failed to set environment for provider '%s'\n", provider_name);
+        return 0;
+    }
+    return 1;
+}
+
 // Print shell wrapper function for installation
 void print_shell_wrapper(const Config *config) {
     printf("# Shell wrapper function for router-switch\n");
@@ -159,7 +187,7 @@ void print_shell_wrapper(const Config *config) {
 
     printf("router-switch() {\n");
     printf("    # Path to router-switch binary (adjust if needed)\n");
-    printf("    local ROUTER_SWITCH_CMD=\"${ROUTER_SWITCH_BIN:-$(dirname \"${BASH_SOURCE[0]:-${(%):-%x}}\")/bin/release/router-switch}\"\n\n");
+    printf("    local ROUTER_SWITCH_CMD=\"${ROUTER_SWITCH_BIN:-$(dirname \"${BASH_SOURCE[0]:-${(%%):-%%x}}\")/bin/release/router-switch}\"\n\n");
 
     printf("    # If no arguments, show help\n");
     printf("    if [ $# -eq 0 ]; then\n");
@@ -188,6 +216,18 @@ void print_shell_wrapper(const Config *config) {
     printf("        return $?\n");
     printf("    fi\n\n");
 
+    printf("    # Subcommands print reports instead of shell commands, run them directly\n");
+    printf("    case \"$1\" in\n");
+    printf("        stats|cooldown|mock-server|replay|forward|publish)\n");
+    printf("            \"$ROUTER_SWITCH_CMD\" \"$@\"\n");
+    printf("            return $?\n");
+    printf("            ;;\n");
+    printf("        sync)\n");
+    printf("            eval \"$(\"$ROUTER_SWITCH_CMD\" \"$@\")\"\n");
+    printf("            return $?\n");
+    printf("            ;;\n");
+    printf("    esac\n\n");
+
     printf("    # Parse arguments\n");
     printf("    local args=()\n");
     printf("    local provider=\"\"\n");
@@ -229,6 +269,8 @@ void print_shell_wrapper(const Config *config) {
     printf("    eval \"$(\"$ROUTER_SWITCH_CMD\" \"${args[@]}\")\"\n");
     printf("}\n\n");
 
+    print_sync_hook();
+
     // Tab completion for zsh
     printf("# Tab completion for zsh\n");
     printf("if command -v compdef >/dev/null 2>&1; then\n");
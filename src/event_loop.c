@@ -0,0 +1,233 @@
+#include "router-switch.h"
+#include <poll.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
+// Readiness-based event loop shared by the network commands (mock-server,
+// replay, forward): epoll on Linux, poll(2) elsewhere, plus a binary min-heap
+// of one-shot timers. Timers are never cancelled; owners compare the tag they
+// scheduled with their current state and ignore stale expirations.
+
+typedef struct {
+    uint64_t due_us;
+    void *data;
+    uint64_t tag;
+} LoopTimer;
+
+struct EventLoop {
+#ifdef __linux__
+    int epoll_fd;
+    struct epoll_event *ready;
+#else
+    struct pollfd *pollfds;
+    void **pollfd_data;
+    int *fd_slots;          // fd -> index into pollfds, -1 when absent
+    int pollfd_count;
+#endif
+    int max_fds;
+    LoopTimer *timers;
+    int timer_count;
+    int timer_capacity;
+};
+
+EventLoop* event_loop_create(int max_fds) {
+    EventLoop *loop = calloc(1, sizeof(EventLoop));
+    if (!loop) return NULL;
+    loop->max_fds = max_fds;
+
+#ifdef __linux__
+    loop->epoll_fd = epoll_create1(0);
+    loop->ready = calloc((size_t)max_fds, sizeof(struct epoll_event));
+    if (loop->epoll_fd < 0 || !loop->ready) {
+        event_loop_destroy(loop);
+        return NULL;
+    }
+#else
+    loop->pollfds = calloc((size_t)max_fds, sizeof(struct pollfd));
+    loop->pollfd_data = calloc((size_t)max_fds, sizeof(void *));
+    loop->fd_slots = malloc(sizeof(int) * (size_t)max_fds);
+    if (!loop->pollfds || !loop->pollfd_data || !loop->fd_slots) {
+        event_loop_destroy(loop);
+        return NULL;
+    }
+    for (int i = 0; i < max_fds; i++) loop->fd_slots[i] = -1;
+#endif
+    return loop;
+}
+
+void event_loop_destroy(EventLoop *loop) {
+    if (!loop) return;
+#ifdef __linux__
+    if (loop->epoll_fd >= 0) close(loop->epoll_fd);
+    free(loop->ready);
+#else
+    free(loop->pollfds);
+    free(loop->pollfd_data);
+    free(loop->fd_slots);
+#endif
+    free(loop->timers);
+    free(loop);
+}
+
+#ifdef __linux__
+static int epoll_control(EventLoop *loop, int op, int fd, uint32_t events, void *data) {
+    struct epoll_event ev = {0};
+    if (events & LOOP_READ) ev.events |= EPOLLIN;
+    if (events & LOOP_WRITE) ev.events |= EPOLLOUT;
+    ev.data.ptr = data;
+    return epoll_ctl(loop->epoll_fd, op, fd, &ev) == 0;
+}
+#else
+static short poll_events(uint32_t events) {
+    short result = 0;
+    if (events & LOOP_READ) result |= POLLIN;
+    if (events & LOOP_WRITE) result |= POLLOUT;
+    return result;
+}
+#endif
+
+int event_loop_add(EventLoop *loop, int fd, uint32_t events, void *data) {
+    if (fd < 0 || fd >= loop->max_fds) return 0;
+#ifdef __linux__
+    return epoll_control(loop, EPOLL_CTL_ADD, fd, events, data);
+#else
+    int slot = loop->pollfd_count++;
+    loop->pollfds[slot].fd = fd;
+    loop->pollfds[slot].events = poll_events(events);
+    loop->pollfds[slot].revents = 0;
+    loop->pollfd_data[slot] = data;
+    loop->fd_slots[fd] = slot;
+    return 1;
+#endif
+}
+
+int event_loop_modify(EventLoop *loop, int fd, uint32_t events, void *data) {
+    if (fd < 0 || fd >= loop->max_fds) return 0;
+#ifdef __linux__
+    return epoll_control(loop, EPOLL_CTL_MOD, fd, events, data);
+#else
+    int slot = loop->fd_slots[fd];
+    if (slot < 0) return 0;
+    loop->pollfds[slot].events = poll_events(events);
+    loop->pollfd_data[slot] = data;
+    return 1;
+#endif
+}
+
+void event_loop_remove(EventLoop *loop, int fd) {
+    if (fd < 0 || fd >= loop->max_fds) return;
+#ifdef __linux__
+    epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+#else
+    int slot = loop->fd_slots[fd];
+    if (slot < 0) return;
+    int last = --loop->pollfd_count;
+    if (slot != last) {
+        loop->pollfds[slot] = loop->pollfds[last];
+        loop->pollfd_data[slot] = loop->pollfd_data[last];
+        loop->fd_slots[loop->pollfds[slot].fd] = slot;
+    }
+    loop->fd_slots[fd] = -1;
+#endif
+}
+
+int event_loop_add_timer(EventLoop *loop, uint64_t due_us, void *data, uint64_t tag) {
+    if (loop->timer_count == loop->timer_capacity) {
+        int capacity = loop->timer_capacity ? loop->timer_capacity * 2 : 256;
+        LoopTimer *timers = realloc(loop->timers, sizeof(LoopTimer) * (size_t)capacity);
+        if (!timers) return 0;
+        loop->timers = timers;
+        loop->timer_capacity = capacity;
+    }
+
+    // Sift up
+    int i = loop->timer_count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (loop->timers[parent].due_us <= due_us) break;
+        loop->timers[i] = loop->timers[parent];
+        i = parent;
+    }
+    loop->timers[i].due_us = due_us;
+    loop->timers[i].data = data;
+    loop->timers[i].tag = tag;
+    return 1;
+}
+
+static LoopTimer pop_timer(EventLoop *loop) {
+    LoopTimer top = loop->timers[0];
+    LoopTimer last = loop->timers[--loop->timer_count];
+
+    // Sift down
+    int i = 0;
+    for (;;) {
+        int child = i * 2 + 1;
+        if (child >= loop->timer_count) break;
+        if (child + 1 < loop->timer_count && loop->timers[child + 1].due_us < loop->timers[child].due_us) {
+            child++;
+        }
+        if (last.due_us <= loop->timers[child].due_us) break;
+        loop->timers[i] = loop->timers[child];
+        i = child;
+    }
+    if (loop->timer_count > 0) loop->timers[i] = last;
+    return top;
+}
+
+// Wait for I/O readiness or timer expiry. Expired timers are reported with
+// LOOP_TIMER and the tag they were scheduled with. Returns the number of
+// events, or -1 on error (EINTR included, so callers can check their signal flags).
+int event_loop_wait(EventLoop *loop, LoopEvent *events, int max_events, int timeout_ms) {
+    uint64_t now = monotonic_time_us();
+    int count = 0;
+
+    while (loop->timer_count > 0 && loop->timers[0].due_us <= now && count < max_events) {
+        LoopTimer timer = pop_timer(loop);
+        events[count].events = LOOP_TIMER;
+        events[count].data = timer.data;
+        events[count].tag = timer.tag;
+        count++;
+    }
+    if (count == max_events) return count;
+    if (count > 0) timeout_ms = 0;
+    if (max_events > loop->max_fds) max_events = loop->max_fds;
+
+    if (loop->timer_count > 0) {
+        uint64_t wait_us = loop->timers[0].due_us - now;
+        int timer_ms = (int)((wait_us + 999) / 1000);
+        if (timeout_ms < 0 || timer_ms < timeout_ms) timeout_ms = timer_ms;
+    }
+
+#ifdef __linux__
+    int ready = epoll_wait(loop->epoll_fd, loop->ready, max_events - count, timeout_ms);
+    if (ready < 0) return count > 0 ? count : -1;
+    for (int i = 0; i < ready; i++) {
+        uint32_t flags = 0;
+        if (loop->ready[i].events & (EPOLLIN | EPOLLHUP)) flags |= LOOP_READ;
+        if (loop->ready[i].events & EPOLLOUT) flags |= LOOP_WRITE;
+        if (loop->ready[i].events & EPOLLERR) flags |= LOOP_ERROR;
+        events[count].events = flags;
+        events[count].data = loop->ready[i].data.ptr;
+        events[count].tag = 0;
+        count++;
+    }
+#else
+    int ready = poll(loop->pollfds, (nfds_t)loop->pollfd_count, timeout_ms);
+    if (ready < 0) return count > 0 ? count : -1;
+    for (int i = 0; i < loop->pollfd_count && ready > 0 && count < max_events; i++) {
+        short revents = loop->pollfds[i].revents;
+        if (!revents) continue;
+        ready--;
+        uint32_t flags = 0;
+        if (revents & (POLLIN | POLLHUP)) flags |= LOOP_READ;
+        if (revents & POLLOUT) flags |= LOOP_WRITE;
+        if (revents & (POLLERR | POLLNVAL)) flags |= LOOP_ERROR;
+        events[count].events = flags;
+        events[count].data = loop->pollfd_data[i];
+        events[count].tag = 0;
+        count++;
+    }
+#endif
+    return count;
+}
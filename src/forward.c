@@ -0,0 +1,1099 @@
+#include "router-switch.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+// Hedged forwarding proxy. Point ANTHROPIC_BASE_URL at it and every request
+// goes to the first provider of an ordered set; if no response headers have
+// arrived by the hedge deadline (a fixed delay, or a percentile of the
+// primary's recent response times), a copy goes to the next provider. The
+// first usable response is streamed back and the other attempts are closed.
+// Requests that fail before answering move on to the next provider at once.
+// A small holdout share of requests is never hedged, as the baseline for the
+// p99 improvement in the report.
+
+#define FORWARD_DEFAULT_PORT 8790
+#define FORWARD_DEFAULT_TIMEOUT_MS 300000
+#define FORWARD_DEFAULT_PERCENTILE 95.0
+#define FORWARD_DEFAULT_DELAY_MS 1000
+#define FORWARD_DEFAULT_HOLDOUT 0.05
+#define FORWARD_MIN_SAMPLES 20          // percentile deadline needs this many primary responses
+#define FORWARD_WINDOW 512              // recent primary response times kept for the percentile
+#define FORWARD_MAX_REQUEST (32 * 1024 * 1024)
+#define FORWARD_MAX_HEADERS (64 * 1024)
+#define FORWARD_READ_CHUNK 16384
+#define FORWARD_MAX_BUFFERED (1024 * 1024)
+#define FORWARD_MAX_EVENTS 1024
+
+enum {
+    FORWARD_LISTENER = 0,   // LoopHandle kinds
+    FORWARD_CLIENT,
+    FORWARD_ATTEMPT
+};
+
+enum {
+    CLIENT_READING = 0,     // waiting for a complete request
+    CLIENT_WAITING,         // attempts in flight, nothing sent back yet
+    CLIENT_RELAYING         // response committed, copying it to the client
+};
+
+enum {
+    ATTEMPT_CONNECTING = 0,
+    ATTEMPT_SENDING,
+    ATTEMPT_RECEIVING,
+    ATTEMPT_RELAYING
+};
+
+typedef struct {
+    const ProviderConfig *provider;
+    char host[MAX_HOST_NAME];
+    int port;
+    char path[MAX_URL_PATH];
+    uint64_t attempts;
+    uint64_t wins;
+    uint64_t cancelled;
+    uint64_t errors;
+} ForwardTarget;
+
+struct ForwardClient;
+
+typedef struct ForwardAttempt {
+    LoopHandle handle;                 // FORWARD_ATTEMPT
+    int fd;
+    uint64_t generation;               // bumped on reuse, stale timers carry an old tag
+    int state;
+    int target;                        // also the attempt's slot in the client
+    int paused;                        // reading stopped until the client drains
+    struct ForwardClient *client;
+    char *out;
+    size_t out_len;
+    size_t out_sent;
+    size_t out_cap;
+    char *in;
+    size_t in_len;
+    size_t in_cap;
+    uint64_t start_us;
+    struct ForwardAttempt *next_free;
+} ForwardAttempt;
+
+typedef struct ForwardClient {
+    LoopHandle handle;                 // FORWARD_CLIENT
+    int fd;
+    uint64_t generation;               // bumped on reuse and per attempt, so only the latest hedge timer counts
+    int state;
+    char *in;
+    size_t in_len;
+    size_t in_cap;
+    size_t header_length;
+    size_t body_length;
+    int continue_sent;
+    char *out;
+    size_t out_len;
+    size_t out_sent;
+    size_t out_cap;
+    int want_write;
+    int upstream_done;
+    ForwardAttempt *attempts[MAX_PROVIDERS];
+    int attempt_count;                 // attempts started, i.e. next target index
+    int pending;                       // attempts still in flight
+    int hedged;
+    int holdout;                       // baseline request, never hedged
+    ForwardAttempt *winner;
+    uint64_t id;
+    uint64_t start_us;
+    struct ForwardClient *next_free;
+} ForwardClient;
+
+typedef struct {
+    LoopHandle handle;                 // FORWARD_LISTENER
+    int fd;
+    EventLoop *loop;
+    ForwardTarget targets[MAX_PROVIDERS];
+    int target_count;
+    int max_attempts;
+    int timeout_ms;
+    int delay_ms;                      // fixed delay, or the deadline until the percentile has samples
+    double percentile;                 // 0 for a fixed delay
+    double holdout;                    // share of requests sent without hedging
+    int keep_model;
+    int verbose;
+    uint32_t window[FORWARD_WINDOW];
+    int window_count;
+    int window_next;
+    int window_changes;
+    uint64_t deadline_us;
+    ForwardClient *free_clients;
+    ForwardAttempt *free_attempts;
+    ForwardClient *released_clients;   // recycled after the current batch of events
+    ForwardAttempt *released_attempts;
+    int max_fds;
+    uint64_t next_id;
+    uint64_t requests;
+    uint64_t hedged;
+    uint64_t hedge_wins;
+    uint64_t failovers;
+    uint64_t failed;
+    uint32_t *latency_us;              // request start to response headers, hedged requests
+    int latency_count;
+    int latency_cap;
+    uint32_t *holdout_us;              // the same for the holdout requests
+    int holdout_count;
+    int holdout_cap;
+} ForwardProxy;
+
+static volatile sig_atomic_t forward_stop_requested = 0;
+
+static void handle_stop_signal(int sig) {
+    (void)sig;
+    forward_stop_requested = 1;
+}
+
+static uint32_t clamp_us(uint64_t value) {
+    return value > UINT32_MAX ? UINT32_MAX : (uint32_t)value;
+}
+
+static void append_sample(uint32_t **values, int *count, int *capacity, uint32_t value) {
+    if (*count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 1024;
+        uint32_t *grown = realloc(*values, sizeof(uint32_t) * (size_t)new_capacity);
+        if (!grown) return;
+        *values = grown;
+        *capacity = new_capacity;
+    }
+    (*values)[(*count)++] = value;
+}
+
+// Make room for at least `need` more bytes, dropping what was already sent
+static int reserve_buffer(char **buffer, size_t *len, size_t *sent, size_t *cap, size_t need) {
+    if (sent && *sent > 0 && *cap - *len <= need) {
+        memmove(*buffer, *buffer + *sent, *len - *sent);
+        *len -= *sent;
+        *sent = 0;
+    }
+    if (*cap - *len > need) return 1;
+
+    size_t capacity = *cap ? *cap * 2 : 8192;
+    while (capacity - *len <= need) capacity *= 2;
+    char *grown = realloc(*buffer, capacity);
+    if (!grown) return 0;
+    *buffer = grown;
+    *cap = capacity;
+    return 1;
+}
+
+static int append_bytes(char **buffer, size_t *len, size_t *sent, size_t *cap, const char *data, size_t size) {
+    if (!reserve_buffer(buffer, len, sent, cap, size)) return 0;
+    memcpy(*buffer + *len, data, size);
+    *len += size;
+    (*buffer)[*len] = '\0';
+    return 1;
+}
+
+static int append_format(char **buffer, size_t *len, size_t *sent, size_t *cap, const char *format, ...) {
+    char text[MAX_COMMAND_LENGTH * 2];
+    va_list args;
+
+    va_start(args, format);
+    int written = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+
+    if (written < 0 || (size_t)written >= sizeof(text)) return 0;
+    return append_bytes(buffer, len, sent, cap, text, (size_t)written);
+}
+
+#define CLIENT_OUT(c) &(c)->out, &(c)->out_len, &(c)->out_sent, &(c)->out_cap
+#define ATTEMPT_OUT(a) &(a)->out, &(a)->out_len, NULL, &(a)->out_cap
+
+// Hop-by-hop and credential headers are replaced, not forwarded
+static int header_is(const char *line, size_t len, const char *name) {
+    size_t name_len = strlen(name);
+    return len > name_len && line[name_len] == ':' && strncasecmp(line, name, name_len) == 0;
+}
+
+static int is_dropped_request_header(const char *line, size_t len) {
+    static const char *names[] = {
+        "Host", "Content-Length", "Connection", "Keep-Alive", "Proxy-Connection", "Transfer-Encoding",
+        "TE", "Upgrade", "Expect", "x-api-key", "Authorization"
+    };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (header_is(line, len, names[i])) return 1;
+    }
+    return 0;
+}
+
+static int is_dropped_response_header(const char *line, size_t len) {
+    return header_is(line, len, "Connection") || header_is(line, len, "Keep-Alive") ||
+           header_is(line, len, "Proxy-Connection");
+}
+
+// Hedge deadline: the configured percentile of the primary's recent response
+// times, recomputed every 16 samples, or the fixed delay
+static uint64_t hedge_deadline_us(ForwardProxy *proxy) {
+    if (proxy->percentile <= 0 || proxy->window_count < FORWARD_MIN_SAMPLES) {
+        return (uint64_t)proxy->delay_ms * 1000u;
+    }
+    if (proxy->deadline_us == 0 || proxy->window_changes >= 16) {
+        uint32_t sorted[FORWARD_WINDOW];
+        memcpy(sorted, proxy->window, sizeof(uint32_t) * (size_t)proxy->window_count);
+        sort_u32(sorted, proxy->window_count);
+        proxy->deadline_us = percentile_u32(sorted, proxy->window_count, proxy->percentile);
+        proxy->window_changes = 0;
+    }
+    return proxy->deadline_us;
+}
+
+static void record_primary_time(ForwardProxy *proxy, uint64_t elapsed_us) {
+    proxy->window[proxy->window_next] = clamp_us(elapsed_us);
+    proxy->window_next = (proxy->window_next + 1) % FORWARD_WINDOW;
+    if (proxy->window_count < FORWARD_WINDOW) proxy->window_count++;
+    proxy->window_changes++;
+}
+
+static ForwardAttempt* acquire_attempt(ForwardProxy *proxy) {
+    ForwardAttempt *attempt = proxy->free_attempts;
+    if (attempt) {
+        proxy->free_attempts = attempt->next_free;
+    } else {
+        attempt = calloc(1, sizeof(ForwardAttempt));
+        if (!attempt) return NULL;
+        attempt->handle.kind = FORWARD_ATTEMPT;
+        attempt->fd = -1;
+    }
+    attempt->generation++;
+    attempt->state = ATTEMPT_CONNECTING;
+    attempt->paused = 0;
+    attempt->out_len = 0;
+    attempt->out_sent = 0;
+    attempt->in_len = 0;
+    attempt->next_free = NULL;
+    return attempt;
+}
+
+// Attempts and clients are recycled, never freed, so pending timers can always check their tag
+static void release_attempt(ForwardProxy *proxy, ForwardAttempt *attempt) {
+    ForwardClient *client = attempt->client;
+    if (client && client->winner == attempt) {
+        client->winner = NULL;
+    } else if (client && client->attempts[attempt->target] == attempt) {
+        client->attempts[attempt->target] = NULL;
+        client->pending--;
+    }
+
+    if (attempt->fd >= 0) {
+        event_loop_remove(proxy->loop, attempt->fd);
+        close(attempt->fd);
+    }
+    attempt->fd = -1;
+    attempt->client = NULL;
+    attempt->generation++;
+    attempt->next_free = proxy->released_attempts;
+    proxy->released_attempts = attempt;
+}
+
+static void close_client(ForwardProxy *proxy, ForwardClient *client) {
+    for (int i = 0; i < client->attempt_count; i++) {
+        if (client->attempts[i]) release_attempt(proxy, client->attempts[i]);
+    }
+    if (client->winner) release_attempt(proxy, client->winner);
+
+    event_loop_remove(proxy->loop, client->fd);
+    close(client->fd);
+    client->fd = -1;
+    client->generation++;
+    client->next_free = proxy->released_clients;
+    proxy->released_clients = client;
+}
+
+// Return this batch's released objects to the free lists. Deferred so that a
+// stale event later in the same batch never lands on an object reused for a new fd.
+static void recycle_released(ForwardProxy *proxy) {
+    while (proxy->released_attempts) {
+        ForwardAttempt *attempt = proxy->released_attempts;
+        proxy->released_attempts = attempt->next_free;
+        attempt->next_free = proxy->free_attempts;
+        proxy->free_attempts = attempt;
+    }
+    while (proxy->released_clients) {
+        ForwardClient *client = proxy->released_clients;
+        proxy->released_clients = client->next_free;
+        client->next_free = proxy->free_clients;
+        proxy->free_clients = client;
+    }
+}
+
+// Write as much pending output as the socket takes; returns 0 if the client was closed
+static int flush_client(ForwardProxy *proxy, ForwardClient *client) {
+    while (client->out_sent < client->out_len) {
+        ssize_t sent = send(client->fd, client->out + client->out_sent, client->out_len - client->out_sent, 0);
+        if (sent > 0) {
+            client->out_sent += (size_t)sent;
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!client->want_write) {
+                client->want_write = 1;
+                event_loop_modify(proxy->loop, client->fd, LOOP_READ | LOOP_WRITE, client);
+            }
+            break;
+        }
+        close_client(proxy, client);
+        return 0;
+    }
+
+    if (client->out_sent == client->out_len) {
+        client->out_len = 0;
+        client->out_sent = 0;
+        if (client->want_write) {
+            client->want_write = 0;
+            event_loop_modify(proxy->loop, client->fd, LOOP_READ, client);
+        }
+        if (client->upstream_done) {
+            close_client(proxy, client);
+            return 0;
+        }
+    }
+
+    // Resume the upstream once the client has caught up
+    ForwardAttempt *winner = client->winner;
+    if (winner && winner->paused && client->out_len - client->out_sent < FORWARD_MAX_BUFFERED / 2) {
+        winner->paused = 0;
+        event_loop_modify(proxy->loop, winner->fd, LOOP_READ, winner);
+    }
+    return 1;
+}
+
+// Answer the client directly and close once it is sent
+static void respond_error(ForwardProxy *proxy, ForwardClient *client, int status, const char *reason,
+                          const char *error_type, const char *message) {
+    char body[512];
+    int length = snprintf(body, sizeof(body),
+                          "{\"type\":\"error\",\"error\":{\"type\":\"%s\",\"message\":\"%s\"}}",
+                          error_type, message);
+
+    client->out_len = 0;
+    client->out_sent = 0;
+    append_format(CLIENT_OUT(client), "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\n"
+                  "Content-Length: %d\r\nConnection: close\r\n\r\n%s", status, reason, length, body);
+    client->state = CLIENT_RELAYING;
+    client->upstream_done = 1;
+    flush_client(proxy, client);
+}
+
+// Rebuild the client's request for one provider: its path prefix, host and key,
+// and (unless --keep-model) one of its models if the requested one is not its own
+static int build_upstream_request(ForwardProxy *proxy, ForwardClient *client, ForwardAttempt *attempt) {
+    ForwardTarget *target = &proxy->targets[attempt->target];
+    const ProviderConfig *provider = target->provider;
+    char method[16] = "";
+    char path[MAX_COMMAND_LENGTH] = "";
+
+    if (sscanf(client->in, "%15s %2047s", method, path) != 2 || path[0] != '/') {
+        return 0;
+    }
+
+    // Same key pool as a switch, so key_policy, key_weights and cooldowns apply
+    const char *key = provider->api_key;
+    if (provider->api_key_count > 0) {
+        key = provider->api_keys[select_api_key(provider)];
+    }
+
+    const char *body = client->in + client->header_length;
+    const char *body_end = body + client->body_length;
+    const char *model = NULL;
+    const char *model_end = NULL;
+    const char *replacement = NULL;
+    if (!proxy->keep_model && provider->model_count > 0 &&
+        find_json_member(body, body_end, "model", &model, &model_end) && *model == '"') {
+        size_t model_len = (size_t)(model_end - model) - 2;
+        replacement = provider->models[0];
+        for (int i = 0; i < provider->model_count; i++) {
+            if (strlen(provider->models[i]) == model_len && strncmp(provider->models[i], model + 1, model_len) == 0) {
+                replacement = NULL;
+                break;
+            }
+        }
+    }
+    size_t content_length = client->body_length;
+    if (replacement) {
+        content_length = content_length - (size_t)(model_end - model) + strlen(replacement) + 2;
+    }
+
+    int ok = append_format(ATTEMPT_OUT(attempt), "%s %s%s HTTP/1.1\r\nHost: %s:%d\r\n",
+                           method, target->path, path, target->host, target->port);
+
+    // Pass the client's own headers through (anthropic-version, anthropic-beta, ...)
+    const char *line = memchr(client->in, '\n', client->header_length);
+    const char *head_end = client->in + client->header_length;
+    while (ok && line && line + 1 < head_end) {
+        line++;
+        const char *line_end = memchr(line, '\n', (size_t)(head_end - line));
+        if (!line_end || line_end - line <= 1) break;
+        if (!is_dropped_request_header(line, (size_t)(line_end - line))) {
+            ok = append_bytes(ATTEMPT_OUT(attempt), line, (size_t)(line_end - line) + 1);
+        }
+        line = line_end;
+    }
+
+    ok = ok && append_format(ATTEMPT_OUT(attempt), "x-api-key: %s\r\nAuthorization: Bearer %s\r\n"
+                             "Content-Length: %zu\r\nConnection: close\r\n\r\n", key, key, content_length);
+    if (replacement) {
+        ok = ok && append_bytes(ATTEMPT_OUT(attempt), body, (size_t)(model - body)) &&
+             append_format(ATTEMPT_OUT(attempt), "\"%s\"", replacement) &&
+             append_bytes(ATTEMPT_OUT(attempt), model_end, (size_t)(body_end - model_end));
+    } else {
+        ok = ok && append_bytes(ATTEMPT_OUT(attempt), body, client->body_length);
+    }
+    return ok;
+}
+
+static void start_attempt(ForwardProxy *proxy, ForwardClient *client);
+
+// An attempt failed before answering: try the next provider if nothing else is in flight
+static void continue_after_failure(ForwardProxy *proxy, ForwardClient *client) {
+    if (client->state != CLIENT_WAITING || client->pending > 0) return;
+
+    if (client->attempt_count < proxy->max_attempts) {
+        proxy->failovers++;
+        start_attempt(proxy, client);
+        return;
+    }
+    proxy->failed++;
+    respond_error(proxy, client, 502, "Bad Gateway", "api_error", "No provider answered the request");
+}
+
+static void fail_attempt(ForwardProxy *proxy, ForwardAttempt *attempt) {
+    ForwardClient *client = attempt->client;
+    proxy->targets[attempt->target].errors++;
+    if (proxy->verbose) {
+        fprintf(stderr, "[#%llu] %s failed after %.1fms\n", (unsigned long long)client->id,
+                proxy->targets[attempt->target].provider->name,
+                (double)(monotonic_time_us() - attempt->start_us) / 1000.0);
+    }
+    release_attempt(proxy, attempt);
+    continue_after_failure(proxy, client);
+}
+
+// Send the request to the next provider of the set and arm the next hedge
+static void start_attempt(ForwardProxy *proxy, ForwardClient *client) {
+    int index = client->attempt_count++;
+    ForwardTarget *target = &proxy->targets[index];
+    ForwardAttempt *attempt = acquire_attempt(proxy);
+
+    client->generation++;
+    target->attempts++;
+    if (!attempt) {
+        target->errors++;
+        continue_after_failure(proxy, client);
+        return;
+    }
+
+    attempt->client = client;
+    attempt->target = index;
+    attempt->start_us = monotonic_time_us();
+    client->attempts[index] = attempt;
+    client->pending++;
+
+    attempt->fd = -1;
+    if (build_upstream_request(proxy, client, attempt)) {
+        attempt->fd = connect_tcp(target->host, target->port);
+    }
+    if (attempt->fd < 0 || attempt->fd >= proxy->max_fds ||
+        !event_loop_add(proxy->loop, attempt->fd, LOOP_WRITE, attempt)) {
+        fail_attempt(proxy, attempt);
+        return;
+    }
+
+    event_loop_add_timer(proxy->loop, attempt->start_us + (uint64_t)proxy->timeout_ms * 1000u,
+                         attempt, attempt->generation);
+    if (!client->holdout && client->attempt_count < proxy->max_attempts) {
+        event_loop_add_timer(proxy->loop, attempt->start_us + hedge_deadline_us(proxy),
+                             client, client->generation);
+    }
+}
+
+// First usable response: close the other attempts and start relaying this one
+static void commit_attempt(ForwardProxy *proxy, ForwardAttempt *attempt, size_t header_length) {
+    ForwardClient *client = attempt->client;
+    ForwardTarget *target = &proxy->targets[attempt->target];
+    uint64_t elapsed = monotonic_time_us() - client->start_us;
+
+    if (client->holdout) {
+        append_sample(&proxy->holdout_us, &proxy->holdout_count, &proxy->holdout_cap, clamp_us(elapsed));
+    } else {
+        append_sample(&proxy->latency_us, &proxy->latency_count, &proxy->latency_cap, clamp_us(elapsed));
+    }
+    if (attempt->target != 0 && client->attempts[0]) {
+        record_primary_time(proxy, elapsed);   // the cancelled primary would have taken at least this long
+    }
+    if (client->hedged && attempt->target != 0) proxy->hedge_wins++;
+    target->wins++;
+
+    client->attempts[attempt->target] = NULL;
+    client->pending--;
+    client->winner = attempt;
+    for (int i = 0; i < client->attempt_count; i++) {
+        if (client->attempts[i]) {
+            proxy->targets[i].cancelled++;
+            release_attempt(proxy, client->attempts[i]);
+        }
+    }
+    client->state = CLIENT_RELAYING;
+    attempt->state = ATTEMPT_RELAYING;
+
+    if (proxy->verbose) {
+        fprintf(stderr, "[#%llu] %s answered in %.1fms%s\n", (unsigned long long)client->id,
+                target->provider->name, (double)elapsed / 1000.0, client->hedged ? " (hedged)" : "");
+    }
+
+    // Status line and headers, minus hop-by-hop ones; the client connection closes after the body
+    const char *line = attempt->in;
+    const char *head_end = attempt->in + header_length;
+    while (line < head_end) {
+        const char *line_end = memchr(line, '\n', (size_t)(head_end - line));
+        if (!line_end || line_end - line <= 1) break;
+        if (line == attempt->in || !is_dropped_response_header(line, (size_t)(line_end - line))) {
+            append_bytes(CLIENT_OUT(client), line, (size_t)(line_end - line) + 1);
+        }
+        line = line_end + 1;
+    }
+    append_format(CLIENT_OUT(client), "x-router-switch-provider: %s\r\nConnection: close\r\n\r\n",
+                  target->provider->name);
+    append_bytes(CLIENT_OUT(client), head_end, attempt->in_len - header_length);
+    attempt->in_len = 0;
+}
+
+// Copy the committed response to the client, pausing while it lags behind
+static void relay_response(ForwardProxy *proxy, ForwardAttempt *attempt) {
+    ForwardClient *client = attempt->client;
+    int closed = 0;
+
+    while (client->out_len - client->out_sent < FORWARD_MAX_BUFFERED) {
+        if (!reserve_buffer(CLIENT_OUT(client), FORWARD_READ_CHUNK)) {
+            closed = 1;
+            break;
+        }
+        ssize_t received = recv(attempt->fd, client->out + client->out_len,
+                                client->out_cap - client->out_len - 1, 0);
+        if (received > 0) {
+            client->out_len += (size_t)received;
+            continue;
+        }
+        if (received < 0 && errno == EINTR) continue;
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        closed = 1;  // upstream finished (Connection: close) or reset
+        break;
+    }
+
+    if (closed) {
+        client->upstream_done = 1;
+        release_attempt(proxy, attempt);
+    } else if (!attempt->paused && client->out_len - client->out_sent >= FORWARD_MAX_BUFFERED) {
+        attempt->paused = 1;
+        event_loop_modify(proxy->loop, attempt->fd, 0, attempt);
+    }
+    flush_client(proxy, client);
+}
+
+static void attempt_readable(ForwardProxy *proxy, ForwardAttempt *attempt) {
+    if (attempt->state == ATTEMPT_RELAYING) {
+        relay_response(proxy, attempt);
+        return;
+    }
+
+    ForwardClient *client = attempt->client;
+    int closed = 0;
+    for (;;) {
+        if (!reserve_buffer(&attempt->in, &attempt->in_len, NULL, &attempt->in_cap, FORWARD_READ_CHUNK)) {
+            closed = 1;
+            break;
+        }
+        ssize_t received = recv(attempt->fd, attempt->in + attempt->in_len,
+                                attempt->in_cap - attempt->in_len - 1, 0);
+        if (received > 0) {
+            attempt->in_len += (size_t)received;
+            if (attempt->in_len > FORWARD_MAX_REQUEST) break;
+            continue;
+        }
+        if (received < 0 && errno == EINTR) continue;
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        closed = 1;
+        break;
+    }
+
+    size_t header_length = http_header_length(attempt->in, attempt->in_len);
+    if (header_length == 0) {
+        if (closed || attempt->in_len > FORWARD_MAX_HEADERS) fail_attempt(proxy, attempt);
+        return;
+    }
+
+    int status = 0;
+    sscanf(attempt->in, "HTTP/%*s %d", &status);
+    if (attempt->target == 0) {
+        record_primary_time(proxy, monotonic_time_us() - attempt->start_us);
+    }
+
+    // Overloaded or failing: let another provider answer while one is left
+    int retriable = status >= 500 || status == 429 || status == 408 || status == 0;
+    if (retriable && (client->pending > 1 || client->attempt_count < proxy->max_attempts)) {
+        fail_attempt(proxy, attempt);
+        return;
+    }
+
+    commit_attempt(proxy, attempt, header_length);
+    if (closed) {
+        client->upstream_done = 1;
+        release_attempt(proxy, attempt);
+        flush_client(proxy, client);
+    } else {
+        event_loop_modify(proxy->loop, attempt->fd, LOOP_READ, attempt);
+        relay_response(proxy, attempt);
+    }
+}
+
+static void attempt_writable(ForwardProxy *proxy, ForwardAttempt *attempt) {
+    if (attempt->state == ATTEMPT_CONNECTING) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(attempt->fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+            fail_attempt(proxy, attempt);
+            return;
+        }
+        attempt->state = ATTEMPT_SENDING;
+    }
+
+    while (attempt->out_sent < attempt->out_len) {
+        ssize_t sent = send(attempt->fd, attempt->out + attempt->out_sent,
+                            attempt->out_len - attempt->out_sent, 0);
+        if (sent > 0) {
+            attempt->out_sent += (size_t)sent;
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        fail_attempt(proxy, attempt);
+        return;
+    }
+
+    attempt->state = ATTEMPT_RECEIVING;
+    event_loop_modify(proxy->loop, attempt->fd, LOOP_READ, attempt);
+}
+
+// Once the whole request is buffered, send it to the primary
+static void process_request(ForwardProxy *proxy, ForwardClient *client) {
+    char value[64];
+
+    if (client->header_length == 0) {
+        client->header_length = http_header_length(client->in, client->in_len);
+        if (client->header_length == 0) {
+            if (client->in_len > FORWARD_MAX_HEADERS) {
+                respond_error(proxy, client, 431, "Request Header Fields Too Large",
+                              "invalid_request_error", "Headers too large");
+            }
+            return;
+        }
+
+        if (http_header_value(client->in, client->header_length, "Transfer-Encoding", value, sizeof(value))) {
+            respond_error(proxy, client, 411, "Length Required", "invalid_request_error",
+                          "Chunked request bodies are not supported");
+            return;
+        }
+        if (http_header_value(client->in, client->header_length, "Content-Length", value, sizeof(value))) {
+            client->body_length = (size_t)strtoul(value, NULL, 10);
+        }
+        if (client->header_length + client->body_length > FORWARD_MAX_REQUEST) {
+            respond_error(proxy, client, 413, "Payload Too Large", "invalid_request_error", "Request too large");
+            return;
+        }
+    }
+
+    if (client->in_len < client->header_length + client->body_length) {
+        if (!client->continue_sent &&
+            http_header_value(client->in, client->header_length, "Expect", value, sizeof(value)) &&
+            strcasecmp(value, "100-continue") == 0) {
+            client->continue_sent = 1;
+            append_format(CLIENT_OUT(client), "HTTP/1.1 100 Continue\r\n\r\n");
+            flush_client(proxy, client);
+        }
+        return;
+    }
+
+    client->state = CLIENT_WAITING;
+    client->id = ++proxy->next_id;
+    client->start_us = monotonic_time_us();
+    proxy->requests++;
+
+    // Spread the holdout evenly: request n is held out when n * share crosses an integer
+    client->holdout = (uint64_t)((double)proxy->requests * proxy->holdout) !=
+                      (uint64_t)((double)(proxy->requests - 1) * proxy->holdout);
+    start_attempt(proxy, client);
+}
+
+static void client_readable(ForwardProxy *proxy, ForwardClient *client) {
+    for (;;) {
+        ssize_t received;
+        if (client->state == CLIENT_READING) {
+            if (!reserve_buffer(&client->in, &client->in_len, NULL, &client->in_cap, FORWARD_READ_CHUNK)) {
+                close_client(proxy, client);
+                return;
+            }
+            received = recv(client->fd, client->in + client->in_len, client->in_cap - client->in_len - 1, 0);
+            if (received > 0) {
+                client->in_len += (size_t)received;
+                client->in[client->in_len] = '\0';
+                if (client->in_len > FORWARD_MAX_REQUEST + FORWARD_MAX_HEADERS) break;
+                continue;
+            }
+        } else {
+            // Anything after the request is ignored; only a hang-up matters
+            char discard[4096];
+            received = recv(client->fd, discard, sizeof(discard), 0);
+            if (received > 0) continue;
+        }
+        if (received < 0 && errno == EINTR) continue;
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        close_client(proxy, client);   // client gave up: the attempts go with it
+        return;
+    }
+
+    if (client->state == CLIENT_READING) {
+        process_request(proxy, client);
+    }
+}
+
+static void accept_clients(ForwardProxy *proxy) {
+    for (;;) {
+        int fd = accept(proxy->fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return;  // EAGAIN, or out of descriptors until some close
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        ForwardClient *client = proxy->free_clients;
+        if (client) {
+            proxy->free_clients = client->next_free;
+        } else {
+            client = calloc(1, sizeof(ForwardClient));
+            if (client) client->handle.kind = FORWARD_CLIENT;
+        }
+        if (!client || fd >= proxy->max_fds || !set_nonblocking(fd)) {
+            if (client) {
+                client->next_free = proxy->free_clients;
+                proxy->free_clients = client;
+            }
+            close(fd);
+            continue;
+        }
+
+        client->fd = fd;
+        client->generation++;
+        client->state = CLIENT_READING;
+        client->in_len = 0;
+        client->header_length = 0;
+        client->body_length = 0;
+        client->continue_sent = 0;
+        client->out_len = 0;
+        client->out_sent = 0;
+        client->want_write = 0;
+        client->upstream_done = 0;
+        client->attempt_count = 0;
+        client->pending = 0;
+        client->hedged = 0;
+        client->holdout = 0;
+        client->winner = NULL;
+        client->next_free = NULL;
+        memset(client->attempts, 0, sizeof(client->attempts));
+
+        if (!event_loop_add(proxy->loop, fd, LOOP_READ, client)) {
+            close(fd);
+            client->fd = -1;
+            client->next_free = proxy->free_clients;
+            proxy->free_clients = client;
+        }
+    }
+}
+
+static void handle_timer(ForwardProxy *proxy, void *data, uint64_t tag) {
+    if (((LoopHandle *)data)->kind == FORWARD_ATTEMPT) {
+        ForwardAttempt *attempt = data;
+        if (attempt->generation == tag && attempt->fd >= 0 && attempt->state != ATTEMPT_RELAYING) {
+            fail_attempt(proxy, attempt);
+        }
+        return;
+    }
+
+    // Hedge deadline: the latest attempt has not answered yet
+    ForwardClient *client = data;
+    if (client->generation != tag || client->fd < 0 || client->state != CLIENT_WAITING ||
+        client->attempt_count >= proxy->max_attempts) {
+        return;
+    }
+    if (!client->hedged) {
+        client->hedged = 1;
+        proxy->hedged++;
+    }
+    start_attempt(proxy, client);
+}
+
+static void print_percentiles(const char *label, uint32_t *values, int count) {
+    sort_u32(values, count);
+    fprintf(stderr, "%-28s %8d %9.1f %9.1f %9.1f\n", label, count,
+            percentile_u32(values, count, 50) / 1000.0, percentile_u32(values, count, 90) / 1000.0,
+            percentile_u32(values, count, 99) / 1000.0);
+}
+
+static void print_report(ForwardProxy *proxy, double elapsed) {
+    double requests = proxy->requests > 0 ? (double)proxy->requests : 1;
+
+    fprintf(stderr, "\nForwarder stopped after %.1fs\n", elapsed);
+    fprintf(stderr, "Requests: %llu, hedged %llu (%.1f%%), won by a hedge %llu, failed over %llu, failed %llu\n",
+            (unsigned long long)proxy->requests, (unsigned long long)proxy->hedged,
+            (double)proxy->hedged * 100.0 / requests, (unsigned long long)proxy->hedge_wins,
+            (unsigned long long)proxy->failovers, (unsigned long long)proxy->failed);
+    if (proxy->percentile > 0) {
+        fprintf(stderr, "Hedge deadline: p%g of %s response time, %.1fms at exit\n", proxy->percentile,
+                proxy->targets[0].provider->name, (double)hedge_deadline_us(proxy) / 1000.0);
+    } else {
+        fprintf(stderr, "Hedge delay: %dms\n", proxy->delay_ms);
+    }
+
+    fprintf(stderr, "\n%-28s %8s %9s %9s %9s\n", "Time to response headers", "Requests", "p50 ms", "p90 ms", "p99 ms");
+    print_percentiles("Hedging on", proxy->latency_us, proxy->latency_count);
+    print_percentiles("Holdout (hedging off)", proxy->holdout_us, proxy->holdout_count);
+    if (proxy->latency_count > 0 && proxy->holdout_count > 0) {
+        double hedged_p99 = percentile_u32(proxy->latency_us, proxy->latency_count, 99) / 1000.0;
+        double holdout_p99 = percentile_u32(proxy->holdout_us, proxy->holdout_count, 99) / 1000.0;
+        fprintf(stderr, "p99 improvement: %.1fms (%.1f%%)%s\n", holdout_p99 - hedged_p99,
+                holdout_p99 > 0 ? (holdout_p99 - hedged_p99) * 100.0 / holdout_p99 : 0,
+                proxy->holdout_count < 100 ? ", few holdout samples" : "");
+    }
+
+    fprintf(stderr, "\n%-20s %10s %10s %10s %10s\n", "Provider", "Attempts", "Wins", "Cancelled", "Errors");
+    for (int i = 0; i < proxy->target_count; i++) {
+        ForwardTarget *target = &proxy->targets[i];
+        fprintf(stderr, "%-20s %10llu %10llu %10llu %10llu\n", target->provider->name,
+                (unsigned long long)target->attempts, (unsigned long long)target->wins,
+                (unsigned long long)target->cancelled, (unsigned long long)target->errors);
+    }
+}
+
+static int parse_forward_options(const CliOptions *options, ForwardProxy *proxy, char providers[][MAX_PROVIDER_NAME],
+                                 int *provider_count, char *bind_address, int *port) {
+    int opt;
+    long number;
+    int delay_set = 0;
+    int percentile_set = 0;
+
+    static struct option long_options[] = {
+        {"provider",         required_argument, 0, 'p'},
+        {"bind",             required_argument, 0, 'b'},
+        {"port",             required_argument, 0, 'P'},
+        {"hedge-delay-ms",   required_argument, 0, 'd'},
+        {"hedge-percentile", required_argument, 0, 'q'},
+        {"max-attempts",     required_argument, 0, 'a'},
+        {"holdout",          required_argument, 0, 'H'},
+        {"timeout-ms",       required_argument, 0, 't'},
+        {"keep-model",       no_argument,       0, 'k'},
+        {0, 0, 0, 0}
+    };
+
+    reset_option_parser();
+    while ((opt = getopt_long(options->command_argc, options->command_argv, "p:b:P:d:q:a:H:t:k",
+                              long_options, NULL)) != -1) {
+        int valid = 1;
+        switch (opt) {
+            case 'p':
+                if (!add_provider_argument(providers, provider_count, optarg)) return 0;
+                break;
+            case 'b':
+                strncpy(bind_address, optarg, MAX_HOST_NAME - 1);
+                bind_address[MAX_HOST_NAME - 1] = '\0';
+                break;
+            case 'P':
+                valid = parse_long_argument(optarg, 1, 65535, &number);
+                *port = (int)number;
+                break;
+            case 'd':
+                valid = parse_long_argument(optarg, 0, MAX_OPTION_MS, &number);
+                proxy->delay_ms = (int)number;
+                delay_set = 1;
+                break;
+            case 'q':
+                valid = parse_double_argument(optarg, 0, 100, &proxy->percentile) &&
+                        proxy->percentile > 0 && proxy->percentile < 100;
+                percentile_set = 1;
+                break;
+            case 'a':
+                valid = parse_long_argument(optarg, 1, MAX_PROVIDERS, &number);
+                proxy->max_attempts = (int)number;
+                break;
+            case 'H':
+                valid = parse_double_argument(optarg, 0, 1, &proxy->holdout);
+                break;
+            case 't':
+                valid = parse_long_argument(optarg, 1, MAX_OPTION_MS, &number);
+                proxy->timeout_ms = (int)number;
+                break;
+            case 'k':
+                proxy->keep_model = 1;
+                break;
+            default:
+                return 0;
+        }
+        if (!valid) {
+            fprintf(stderr, "Error: Invalid forward option value '%s'\n", optarg);
+            return 0;
+        }
+    }
+
+    // A delay alone is a fixed deadline; with a percentile it only covers the warm-up
+    if (delay_set && !percentile_set) {
+        proxy->percentile = 0;
+    }
+
+    return optind == options->command_argc;
+}
+
+// Forward requests to an ordered provider set with hedging until interrupted, then report
+int run_forward_command(const CliOptions *options) {
+    static ForwardProxy proxy;
+    static Config config;
+    char providers[MAX_PROVIDERS][MAX_PROVIDER_NAME];
+    char bind_address[MAX_HOST_NAME] = "127.0.0.1";
+    int provider_count = 0;
+    int port = FORWARD_DEFAULT_PORT;
+
+    proxy.handle.kind = FORWARD_LISTENER;
+    proxy.percentile = FORWARD_DEFAULT_PERCENTILE;
+    proxy.delay_ms = FORWARD_DEFAULT_DELAY_MS;
+    proxy.max_attempts = 2;
+    proxy.holdout = FORWARD_DEFAULT_HOLDOUT;
+    proxy.timeout_ms = FORWARD_DEFAULT_TIMEOUT_MS;
+    proxy.verbose = options->verbose;
+    if (strlen(options->provider) > 0) {
+        strcpy(providers[provider_count++], options->provider);
+    }
+
+    if (!parse_forward_options(options, &proxy, providers, &provider_count, bind_address, &port)) {
+        fprintf(stderr, "Usage: router-switch forward [-p <provider>]... [--bind <addr>] [--port <n>]\n"
+                        "         [--hedge-delay-ms <n>] [--hedge-percentile <p>] [--max-attempts <n>]\n"
+                        "         [--holdout <0..1>] [--timeout-ms <n>] [--keep-model]\n");
+        return 1;
+    }
+
+    if (!load_config(resolve_config_path(options), &config)) {
+        return 1;
+    }
+
+    // Default to every configured provider, in config order
+    if (provider_count == 0) {
+        for (int i = 0; i < config.provider_count; i++) {
+            strcpy(providers[provider_count++], config.providers[i].name);
+        }
+    }
+
+    for (int i = 0; i < provider_count; i++) {
+        if (!validate_provider_and_model(&config, providers[i], NULL)) {
+            return 1;
+        }
+
+        ForwardTarget *target = &proxy.targets[proxy.target_count++];
+        target->provider = find_provider(&config, providers[i]);
+        if (!parse_http_url(target->provider->base_url, target->host, sizeof(target->host), &target->port,
+                            target->path, sizeof(target->path))) {
+            fprintf(stderr, "Error: Provider '%s' base_url '%s' is not a plain http:// URL "
+                    "(forward has no TLS support, use a local TLS-terminating proxy)\n",
+                    target->provider->name, target->provider->base_url);
+            return 1;
+        }
+    }
+    if (proxy.max_attempts > proxy.target_count) {
+        proxy.max_attempts = proxy.target_count;
+    }
+
+    proxy.max_fds = raise_fd_limit();
+    proxy.loop = event_loop_create(proxy.max_fds);
+    if (!proxy.loop) {
+        fprintf(stderr, "Error: Failed to create event loop\n");
+        return 1;
+    }
+
+    proxy.fd = listen_tcp(bind_address, port);
+    if (proxy.fd < 0 || !event_loop_add(proxy.loop, proxy.fd, LOOP_READ, &proxy)) {
+        fprintf(stderr, "Error: Failed to listen on %s:%d: %s\n", bind_address, port, strerror(errno));
+        return 1;
+    }
+
+    fprintf(stderr, "Forwarding http://%s:%d to", bind_address, port);
+    for (int i = 0; i < proxy.target_count; i++) {
+        fprintf(stderr, "%s %s", i == 0 ? "" : (i < proxy.max_attempts ? " ->" : ","),
+                proxy.targets[i].provider->name);
+    }
+    if (proxy.max_attempts < 2) {
+        fprintf(stderr, " (no hedging)\n");
+    } else if (proxy.percentile > 0) {
+        fprintf(stderr, " (hedge after p%g of %s, %dms until %d responses)\n", proxy.percentile,
+                proxy.targets[0].provider->name, proxy.delay_ms, FORWARD_MIN_SAMPLES);
+    } else {
+        fprintf(stderr, " (hedge after %dms)\n", proxy.delay_ms);
+    }
+    if (proxy.max_attempts > 1 && proxy.holdout > 0) {
+        fprintf(stderr, "%.0f%% of requests go unhedged as the baseline (--holdout)\n", proxy.holdout * 100);
+    }
+    fprintf(stderr, "Press Ctrl-C to stop\n");
+
+    struct sigaction action = {0};
+    action.sa_handler = handle_stop_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    LoopEvent events[FORWARD_MAX_EVENTS];
+    uint64_t started = monotonic_time_us();
+
+    while (!forward_stop_requested) {
+        int count = event_loop_wait(proxy.loop, events, FORWARD_MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "Error: Event loop failed: %s\n", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            int kind = ((LoopHandle *)events[i].data)->kind;
+            if (events[i].events & LOOP_TIMER) {
+                handle_timer(&proxy, events[i].data, events[i].tag);
+                continue;
+            }
+
+            if (kind == FORWARD_LISTENER) {
+                accept_clients(&proxy);
+            } else if (kind == FORWARD_CLIENT) {
+                ForwardClient *client = events[i].data;
+                if (client->fd < 0) continue;
+                if ((events[i].events & LOOP_WRITE) && !flush_client(&proxy, client)) continue;
+                if (events[i].events & (LOOP_READ | LOOP_ERROR)) client_readable(&proxy, client);
+            } else {
+                ForwardAttempt *attempt = events[i].data;
+                if (attempt->fd < 0) continue;
+                if (attempt->state < ATTEMPT_RECEIVING) {
+                    if (events[i].events & (LOOP_WRITE | LOOP_ERROR)) attempt_writable(&proxy, attempt);
+                } else if (events[i].events & (LOOP_READ | LOOP_ERROR)) {
+                    attempt_readable(&proxy, attempt);
+                }
+            }
+        }
+        recycle_released(&proxy);
+    }
+
+    print_report(&proxy, (double)(monotonic_time_us() - started) / 1e6);
+    close(proxy.fd);
+    event_loop_destroy(proxy.loop);
+    return 0;
+}
@@ -69,6 +69,288 @@ static const char* find_json_value(const char *json, const char *key) {
     return value;
 }
 
+// Extract the first string value stored under key (caller frees)
+char* extract_json_string(const char *json, const char *key) {
+    const char *value = find_json_value(json, key);
+    if (!value || *value != '"') return NULL;
+
+    int end;
+    return extract_string_between_quotes(value, &end);
+}
+
+// Extract the first boolean value stored under key
+int extract_json_bool(const char *json, const char *key, int default_value) {
+    const char *value = find_json_value(json, key);
+    if (value && strncmp(value, "true", 4) == 0) return 1;
+    if (value && strncmp(value, "false", 5) == 0) return 0;
+    return default_value;
+}
+
+// Parse a JSON array of strings into fixed-size rows; returns the element count
+static int parse_string_array(const char *array, char *values, size_t row_size, int max_values) {
+    const char *current = array + 1; // Skip opening bracket
+    int count = 0;
+
+    while (*current && *current != ']' && count < max_values) {
+        while (*current && (isspace(*current) || *current == ',')) current++;
+        if (*current == ']' || *current == '\0') break;
+
+        if (*current == '"') {
+            int value_end;
+            char *value = extract_string_between_quotes(current, &value_end);
+            if (!value) break;
+            strncpy(values + (size_t)count * row_size, value, row_size - 1);
+            free(value);
+            count++;
+            current += value_end;
+        } else {
+            current++;
+        }
+    }
+    return count;
+}
+
+// Parse a JSON array of integers; returns the element count
+static int parse_int_array(const char *array, int *values, int max_values) {
+    const char *current = array + 1; // Skip opening bracket
+    int count = 0;
+
+    while (*current && *current != ']' && count < max_values) {
+        while (*current && (isspace(*current) || *current == ',')) current++;
+        if (*current == ']' || *current == '\0') break;
+
+        char *end;
+        long value = strtol(current, &end, 10);
+        if (end == current) break;
+        values[count++] = (int)value;
+        current = end;
+    }
+    return count;
+}
+
+// Parse api_keys, key_weights and key_policy of one provider object. Returns 1
+// on success, 0 on an invalid key_policy and -1 on invalid key_weights.
+static int parse_key_pool_fields(const char *object, ProviderConfig *provider) {
+    // API key pool
+    const char *keys_value = find_json_value(object, "api_keys");
+    if (keys_value && *keys_value == '[') {
+        provider->api_key_count = parse_string_array(keys_value, provider->api_keys[0],
+                                                     sizeof(provider->api_keys[0]), MAX_API_KEYS);
+    }
+
+    // Key weights (weighted policy), defaulting to 1 per key; 0 disables a key
+    int weight_count = 0;
+    int total_weight = 0;
+    const char *weights_value = find_json_value(object, "key_weights");
+    if (weights_value && *weights_value == '[') {
+        weight_count = parse_int_array(weights_value, provider->key_weights, MAX_API_KEYS);
+    }
+    for (int i = 0; i < MAX_API_KEYS; i++) {
+        if (i >= weight_count) provider->key_weights[i] = 1;
+        else if (provider->key_weights[i] < 0) return -1;
+        if (i < provider->api_key_count) total_weight += provider->key_weights[i];
+    }
+    if (provider->api_key_count > 0 && total_weight == 0) {
+        return -1;
+    }
+
+    // Key selection policy
+    const char *policy_value = find_json_value(object, "key_policy");
+    if (policy_value && *policy_value == '"') {
+        int policy_end;
+        char *policy = extract_string_between_quotes(policy_value, &policy_end);
+        if (policy) {
+            if (strcmp(policy, "round-robin") == 0) {
+                provider->key_policy = KEY_POLICY_ROUND_ROBIN;
+            } else if (strcmp(policy, "lru") == 0 || strcmp(policy, "least-recently-used") == 0) {
+                provider->key_policy = KEY_POLICY_LEAST_RECENTLY_USED;
+            } else if (strcmp(policy, "weighted") == 0) {
+                provider->key_policy = KEY_POLICY_WEIGHTED;
+            } else {
+                free(policy);
+                return 0;
+            }
+            free(policy);
+        }
+    }
+
+    return 1;
+}
+
+// Parse the fields of one provider object. Returns 1 on success, 0 on an
+// invalid key_policy and -1 on invalid key_weights.
+static int parse_provider_fields(const char *object, ProviderConfig *provider) {
+    // Description
+    const char *desc_value = find_json_value(object, "description");
+    if (desc_value && *desc_value == '"') {
+        int desc_end;
+        char *desc = extract_string_between_quotes(desc_value, &desc_end);
+        if (desc) {
+            strncpy(provider->description, desc, sizeof(provider->description) - 1);
+            free(desc);
+        }
+    }
+
+    // Base URL
+    const char *url_value = find_json_value(object, "base_url");
+    if (url_value && *url_value == '"') {
+        int url_end;
+        char *url = extract_string_between_quotes(url_value, &url_end);
+        if (url) {
+            strncpy(provider->base_url, url, sizeof(provider->base_url) - 1);
+            free(url);
+        }
+    }
+
+    // API Key
+    const char *key_value = find_json_value(object, "api_key");
+    if (key_value && *key_value == '"') {
+        int key_end;
+        char *key = extract_string_between_quotes(key_value, &key_end);
+        if (key) {
+            strncpy(provider->api_key, key, sizeof(provider->api_key) - 1);
+            free(key);
+        }
+    }
+
+    int key_fields = parse_key_pool_fields(object, provider);
+    if (key_fields != 1) {
+        return key_fields;
+    }
+
+    // Models array
+    const char *models_value = find_json_value(object, "models");
+    if (models_value && *models_value == '[') {
+        const char *array_start = models_value + 1;
+        const char *array_end = array_start;
+
+        while (*array_end && *array_end != ']') array_end++;
+
+        // Parse models in the array
+        const char *model_current = array_start;
+        provider->model_count = 0;
+
+        while (*model_current && *model_current != ']' && provider->model_count < MAX_MODELS_PER_PROVIDER) {
+            while (*model_current && (isspace(*model_current) || *model_current == ',')) model_current++;
+            if (*model_current == ']' || *model_current == '\0') break;
+
+            if (*model_current == '"') {
+                int model_end;
+                char *model = extract_string_between_quotes(model_current, &model_end);
+                if (model) {
+                    strncpy(provider->models[provider->model_count], model, MAX_MODEL_NAME - 1);
+                    free(model);
+                    provider->model_count++;
+                }
+                model_current += model_end;
+            } else {
+                model_current++;
+            }
+        }
+    }
+
+    // Environment variables object
+    const char *env_value = find_json_value(object, "env");
+    if (env_value && *env_value == '{') {
+        const char *env_start = env_value + 1;
+        const char *env_end = env_start;
+        int brace_count = 1;
+
+        while (*env_end && brace_count > 0) {
+            if (*env_end == '{') brace_count++;
+            else if (*env_end == '}') brace_count--;
+            env_end++;
+        }
+
+        // Parse environment variables
+        const char *env_current = env_start;
+        provider->env_count = 0;
+
+        while (*env_current && *env_current != '}' && provider->env_count < MAX_PROVIDERS) {
+            while (*env_current && (isspace(*env_current) || *env_current == ',')) env_current++;
+            if (*env_current == '}' || *env_current == '\0') break;
+
+            if (*env_current == '"') {
+                // Extract key
+                int key_end;
+                char *env_key = extract_string_between_quotes(env_current, &key_end);
+                env_current += key_end;
+
+                // Skip to colon and value
+                while (*env_current && (isspace(*env_current) || *env_current == ':')) env_current++;
+
+                if (*env_current == '"') {
+                    int value_end;
+                    char *env_value = extract_string_between_quotes(env_current, &value_end);
+                    if (env_key && env_value) {
+                        strncpy(provider->env_names[provider->env_count], env_key, MAX_ENV_VAR_NAME - 1);
+                        strncpy(provider->env_values[provider->env_count], env_value, MAX_ENV_VAR_VALUE - 1);
+                        provider->env_count++;
+                    }
+                    if (env_key) free(env_key);
+                    if (env_value) free(env_value);
+                    env_current += value_end;
+                }
+            } else {
+                env_current++;
+            }
+        }
+    }
+
+    return 1;
+}
+
+// Step to the next member of the providers object. Returns the position after
+// the member and sets name/object (caller frees both), or NULL at the end.
+static const char* next_provider_member(const char *current, char **name, char **object) {
+    // Skip whitespace
+    while (*current && isspace(*current)) current++;
+    if (*current == '}' || *current == '\0') return NULL;
+
+    // Extract provider name (key)
+    int name_end;
+    *name = extract_string_between_quotes(current, &name_end);
+    if (!*name) return NULL;
+
+    current += name_end;
+
+    // Skip whitespace and colon
+    while (*current && (isspace(*current) || *current == ':')) current++;
+    if (*current != '{') {
+        free(*name);
+        return NULL;
+    }
+
+    // Find the end of this provider object
+    int brace_count = 1;
+    const char *provider_start = current + 1; // Skip opening brace
+    const char *provider_end = provider_start;
+
+    while (*provider_end && brace_count > 0) {
+        if (*provider_end == '{') brace_count++;
+        else if (*provider_end == '}') brace_count--;
+        provider_end++;
+    }
+
+    if (brace_count > 0) {
+        free(*name);
+        return NULL;
+    }
+
+    // Extract provider object content (without braces)
+    int provider_obj_len = provider_end - current - 1;
+    *object = malloc(provider_obj_len + 1);
+    if (!*object) {
+        free(*name);
+        return NULL;
+    }
+
+    strncpy(*object, current + 1, provider_obj_len);
+    (*object)[provider_obj_len] = '\0';
+
+    return provider_end;
+}
+
 int parse_config_file(const char *filename, Config *config) {
     FILE *file;
     char *content = NULL;
@@ -118,172 +400,142 @@ int parse_config_file(const char *filename, Config *config) {
     int provider_count = 0;
 
     while (*current && *current != '}' && provider_count < MAX_PROVIDERS) {
-        // Skip whitespace
-        while (*current && isspace(*current)) current++;
-        if (*current == '}' || *current == '\0') break;
-
-        // Extract provider name (key)
-        int name_end;
-        char *provider_name = extract_string_between_quotes(current, &name_end);
-        if (!provider_name) break;
-
-        current += name_end;
-
-        // Skip whitespace and colon
-        while (*current && (isspace(*current) || *current == ':')) current++;
-        if (*current != '{') {
-            free(provider_name);
-            break;
-        }
+        char *provider_name;
+        char *provider_obj;
+        const char *next = next_provider_member(current, &provider_name, &provider_obj);
+        if (!next) break;
 
         ProviderConfig *provider = &config->providers[provider_count];
         strncpy(provider->name, provider_name, MAX_PROVIDER_NAME - 1);
         provider->name[MAX_PROVIDER_NAME - 1] = '\0';
         free(provider_name);
 
-        // Find the end of this provider object
-        int brace_count = 1;
-        const char *provider_start = current + 1; // Skip opening brace
-        const char *provider_end = provider_start;
-
-        while (*provider_end && brace_count > 0) {
-            if (*provider_end == '{') brace_count++;
-            else if (*provider_end == '}') brace_count--;
-            provider_end++;
+        int fields = parse_provider_fields(provider_obj, provider);
+        if (fields != 1) {
+            if (fields == 0) {
+                char *policy = extract_json_string(provider_obj, "key_policy");
+                fprintf(stderr, "Invalid key_policy '%s' for provider '%s' "
+                        "(use round-robin, lru or weighted)\n", policy ? policy : "", provider->name);
+                free(policy);
+            } else {
+                fprintf(stderr, "Invalid key_weights for provider '%s' "
+                        "(weights must not be negative and at least one key needs a positive weight)\n",
+                        provider->name);
+            }
+            free(provider_obj);
+            free(content);
+            return 0;
         }
 
-        if (brace_count > 0) break;
-
-        // Extract provider object content (without braces)
-        int provider_obj_len = provider_end - current - 1;
-        char *provider_obj = malloc(provider_obj_len + 1);
-        if (!provider_obj) break;
-
-        strncpy(provider_obj, current + 1, provider_obj_len);
-        provider_obj[provider_obj_len] = '\0';
+        free(provider_obj);
+        current = next;
+        provider_count++;
+    }
 
-        // Parse fields within provider object
+    config->provider_count = provider_count;
+    free(content);
+    result = 1;
 
-        // Description
-        const char *desc_value = find_json_value(provider_obj, "description");
-        if (desc_value && *desc_value == '"') {
-            int desc_end;
-            char *desc = extract_string_between_quotes(desc_value, &desc_end);
-            if (desc) {
-                strncpy(provider->description, desc, sizeof(provider->description) - 1);
-                free(desc);
-            }
-        }
+    return result;
+}
 
-        // Base URL
-        const char *url_value = find_json_value(provider_obj, "base_url");
-        if (url_value && *url_value == '"') {
-            int url_end;
-            char *url = extract_string_between_quotes(url_value, &url_end);
-            if (url) {
-                strncpy(provider->base_url, url, sizeof(provider->base_url) - 1);
-                free(url);
-            }
-        }
+// Parse only the named provider out of an in-memory config document, for the
+// lite switch path. Returns 0 if it is missing or invalid; the caller then
+// falls back to the full parser for the error message.
+int parse_config_provider(const char *json, const char *provider_name, ProviderConfig *provider) {
+    memset(provider, 0, sizeof(ProviderConfig));
 
-        // API Key
-        const char *key_value = find_json_value(provider_obj, "api_key");
-        if (key_value && *key_value == '"') {
-            int key_end;
-            char *key = extract_string_between_quotes(key_value, &key_end);
-            if (key) {
-                strncpy(provider->api_key, key, sizeof(provider->api_key) - 1);
-                free(key);
-            }
-        }
+    const char *providers_value = find_json_value(json, "providers");
+    if (!providers_value || *providers_value != '{') {
+        return 0;
+    }
 
-        // Models array
-        const char *models_value = find_json_value(provider_obj, "models");
-        if (models_value && *models_value == '[') {
-            const char *array_start = models_value + 1;
-            const char *array_end = array_start;
-
-            while (*array_end && *array_end != ']') array_end++;
-
-            // Parse models in the array
-            const char *model_current = array_start;
-            provider->model_count = 0;
-
-            while (*model_current && *model_current != ']' && provider->model_count < MAX_MODELS_PER_PROVIDER) {
-                while (*model_current && (isspace(*model_current) || *model_current == ',')) model_current++;
-                if (*model_current == ']' || *model_current == '\0') break;
-
-                if (*model_current == '"') {
-                    int model_end;
-                    char *model = extract_string_between_quotes(model_current, &model_end);
-                    if (model) {
-                        strncpy(provider->models[provider->model_count], model, MAX_MODEL_NAME - 1);
-                        free(model);
-                        provider->model_count++;
-                    }
-                    model_current += model_end;
-                } else {
-                    model_current++;
-                }
-            }
+    // Same walk and MAX_PROVIDERS cut-off as parse_config_file. The key pool
+    // fields of the other providers are checked too, since the full parser
+    // rejects the whole file when one of them is invalid.
+    static ProviderConfig scratch;
+    const char *current = providers_value + 1;
+    int found = 0;
+
+    for (int index = 0; found >= 0 && *current && *current != '}' && index < MAX_PROVIDERS; index++) {
+        char *name;
+        char *object;
+        const char *next = next_provider_member(current, &name, &object);
+        if (!next) break;
+
+        char truncated[MAX_PROVIDER_NAME] = {0};
+        strncpy(truncated, name, MAX_PROVIDER_NAME - 1);
+        if (!found && strcmp(truncated, provider_name) == 0) {
+            memcpy(provider->name, truncated, MAX_PROVIDER_NAME);
+            found = parse_provider_fields(object, provider) == 1 ? 1 : -1;
+        } else if (find_json_value(object, "key_policy") || find_json_value(object, "key_weights")) {
+            memset(&scratch, 0, sizeof(scratch));
+            if (parse_key_pool_fields(object, &scratch) != 1) found = -1;
         }
+        free(name);
+        free(object);
+        current = next;
+    }
 
-        // Environment variables object
-        const char *env_value = find_json_value(provider_obj, "env");
-        if (env_value && *env_value == '{') {
-            const char *env_start = env_value + 1;
-            const char *env_end = env_start;
-            int brace_count = 1;
-
-            while (*env_end && brace_count > 0) {
-                if (*env_end == '{') brace_count++;
-                else if (*env_end == '}') brace_count--;
-                env_end++;
-            }
+    return found == 1;
+}
 
-            // Parse environment variables
-            const char *env_current = env_start;
-            provider->env_count = 0;
+// Skip a JSON string starting at the opening quote; returns the position after it
+static const char* skip_json_string(const char *p, const char *end) {
+    for (p++; p < end; p++) {
+        if (*p == '\\') p++;
+        else if (*p == '"') return p + 1;
+    }
+    return end;
+}
 
-            while (*env_current && *env_current != '}' && provider->env_count < MAX_PROVIDERS) {
-                while (*env_current && (isspace(*env_current) || *env_current == ',')) env_current++;
-                if (*env_current == '}' || *env_current == '\0') break;
+// Skip one JSON value of any type
+static const char* skip_json_value(const char *p, const char *end) {
+    if (p >= end) return end;
+    if (*p == '"') return skip_json_string(p, end);
+    if (*p != '{' && *p != '[') {
+        while (p < end && *p != ',' && *p != '}' && *p != ']' && !isspace((unsigned char)*p)) p++;
+        return p;
+    }
 
-                if (*env_current == '"') {
-                    // Extract key
-                    int key_end;
-                    char *env_key = extract_string_between_quotes(env_current, &key_end);
-                    env_current += key_end;
-
-                    // Skip to colon and value
-                    while (*env_current && (isspace(*env_current) || *env_current == ':')) env_current++;
-
-                    if (*env_current == '"') {
-                        int value_end;
-                        char *env_value = extract_string_between_quotes(env_current, &value_end);
-                        if (env_key && env_value) {
-                            strncpy(provider->env_names[provider->env_count], env_key, MAX_ENV_VAR_NAME - 1);
-                            strncpy(provider->env_values[provider->env_count], env_value, MAX_ENV_VAR_VALUE - 1);
-                            provider->env_count++;
-                        }
-                        if (env_key) free(env_key);
-                        if (env_value) free(env_value);
-                        env_current += value_end;
-                    }
-                } else {
-                    env_current++;
-                }
-            }
+    int depth = 0;
+    while (p < end) {
+        if (*p == '"') {
+            p = skip_json_string(p, end);
+            continue;
         }
-
-        free(provider_obj);
-        current = provider_end;
-        provider_count++;
+        if (*p == '{' || *p == '[') depth++;
+        else if ((*p == '}' || *p == ']') && --depth == 0) return p + 1;
+        p++;
     }
+    return end;
+}
 
-    config->provider_count = provider_count;
-    free(content);
-    result = 1;
-
-    return result;
-}
\ No newline at end of file
+// Locate a top-level member of a JSON object (nested keys and string contents
+// are skipped, unlike the first-match lookups above); used on request bodies
+int find_json_member(const char *object, const char *end, const char *key,
+                     const char **value, const char **value_end) {
+    size_t key_len = strlen(key);
+    const char *p = object;
+
+    while (p < end && *p != '{') p++;
+    p++;
+    while (p < end) {
+        while (p < end && (isspace((unsigned char)*p) || *p == ',')) p++;
+        if (p >= end || *p != '"') return 0;
+
+        const char *name = p + 1;
+        p = skip_json_string(p, end);
+        int matches = (size_t)(p - 1 - name) == key_len && strncmp(name, key, key_len) == 0;
+
+        while (p < end && (isspace((unsigned char)*p) || *p == ':')) p++;
+        const char *start = p;
+        p = skip_json_value(p, end);
+        if (matches) {
+            *value = start;
+            *value_end = p;
+            return 1;
+        }
+    }
+    return 0;
+}
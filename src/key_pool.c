@@ -0,0 +1,293 @@
+#include "router-switch.h"
+#include <time.h>
+
+#define KEY_POOL_FILE "keys.state"
+#define KEY_POOL_MAGIC 0x4b505352u // "RSPK"
+#define KEY_POOL_VERSION 1
+#define DEFAULT_COOLDOWN_SECONDS 60
+#define MAX_COOLDOWN_SECONDS (30 * 24 * 3600)
+#define MAX_SELECT_ATTEMPTS 16
+
+static uint64_t wall_time_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static KeyPoolState* attach_key_pool_state(void) {
+    KeyPoolState *state = map_state_file(KEY_POOL_FILE, sizeof(KeyPoolState));
+    if (!state) return NULL;
+
+    uint32_t expected = 0;
+    if (__atomic_load_n(&state->magic, __ATOMIC_ACQUIRE) == 0) {
+        state->version = KEY_POOL_VERSION;
+        __atomic_compare_exchange_n(&state->magic, &expected, KEY_POOL_MAGIC, 0,
+                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+    }
+
+    if (__atomic_load_n(&state->magic, __ATOMIC_ACQUIRE) != KEY_POOL_MAGIC ||
+        state->version != KEY_POOL_VERSION) {
+        unmap_state_file(state, sizeof(KeyPoolState));
+        return NULL;
+    }
+    return state;
+}
+
+// Find the slot for a provider, claiming an empty one with a CAS if needed
+// (open addressing on the provider name hash)
+static KeyPoolSlot* find_key_pool(KeyPoolState *state, const char *provider_name) {
+    uint32_t start = hash_provider_name(provider_name, 0) % MAX_KEY_POOLS;
+
+    for (int probe = 0; probe < MAX_KEY_POOLS; probe++) {
+        KeyPoolSlot *slot = &state->pools[(start + probe) % MAX_KEY_POOLS];
+        uint32_t slot_state = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+
+        if (slot_state == 0) {
+            uint32_t expected = 0;
+            if (__atomic_compare_exchange_n(&slot->state, &expected, 1, 0,
+                                            __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+                strncpy(slot->provider, provider_name, MAX_PROVIDER_NAME - 1);
+                slot->provider[MAX_PROVIDER_NAME - 1] = '\0';
+                __atomic_store_n(&slot->state, 2, __ATOMIC_RELEASE);
+                return slot;
+            }
+            slot_state = expected;
+        }
+
+        // Another process is writing the name; it only takes a few stores
+        for (int spin = 0; slot_state == 1 && spin < 100000; spin++) {
+            slot_state = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+        }
+
+        if (slot_state == 2 && strncmp(slot->provider, provider_name, MAX_PROVIDER_NAME) == 0) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+static int is_cooling_down(const KeyPoolSlot *slot, int index, uint64_t now_s) {
+    return __atomic_load_n(&slot->cooldown_until[index], __ATOMIC_RELAXED) > now_s;
+}
+
+// Fallback when every key is throttled: the one that recovers first,
+// never one disabled by a zero weight
+static int earliest_recovery(const KeyPoolSlot *slot, int count, const int *weights) {
+    int best = -1;
+    for (int i = 0; i < count; i++) {
+        if (weights && weights[i] == 0) continue;
+        if (best < 0 || __atomic_load_n(&slot->cooldown_until[i], __ATOMIC_RELAXED) <
+                        __atomic_load_n(&slot->cooldown_until[best], __ATOMIC_RELAXED)) {
+            best = i;
+        }
+    }
+    return best < 0 ? 0 : best;
+}
+
+static int select_round_robin(KeyPoolSlot *slot, int count, uint64_t now_s) {
+    uint64_t ticket = __atomic_fetch_add(&slot->counter, 1, __ATOMIC_RELAXED);
+    for (int i = 0; i < count; i++) {
+        int index = (int)((ticket + (uint64_t)i) % (uint64_t)count);
+        if (!is_cooling_down(slot, index, now_s)) return index;
+    }
+    return earliest_recovery(slot, count, NULL);
+}
+
+static int select_weighted(KeyPoolSlot *slot, int count, const int *weights, uint64_t now_s) {
+    uint64_t total = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (!is_cooling_down(slot, i, now_s)) total += (uint64_t)weights[i];
+    }
+    if (total == 0) return earliest_recovery(slot, count, weights);
+
+    uint64_t ticket = __atomic_fetch_add(&slot->counter, 1, __ATOMIC_RELAXED) % total;
+    for (int i = 0; i < count; i++) {
+        if (is_cooling_down(slot, i, now_s)) continue;
+        if (ticket < (uint64_t)weights[i]) return i;
+        ticket -= (uint64_t)weights[i];
+    }
+    return earliest_recovery(slot, count, weights);
+}
+
+// Claim the least recently used key by CAS-ing its timestamp; a lost race retries
+static int select_least_recently_used(KeyPoolSlot *slot, int count, uint64_t now_s, uint64_t now_us) {
+    for (int attempt = 0; attempt < MAX_SELECT_ATTEMPTS; attempt++) {
+        int best = -1;
+        uint64_t best_used = 0;
+
+        for (int i = 0; i < count; i++) {
+            if (is_cooling_down(slot, i, now_s)) continue;
+            uint64_t used = __atomic_load_n(&slot->last_used[i], __ATOMIC_RELAXED);
+            if (best < 0 || used < best_used) {
+                best = i;
+                best_used = used;
+            }
+        }
+        if (best < 0) return earliest_recovery(slot, count, NULL);
+
+        uint64_t claimed = now_us > best_used ? now_us : best_used + 1;
+        if (__atomic_compare_exchange_n(&slot->last_used[best], &best_used, claimed, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return best;
+        }
+    }
+    return select_round_robin(slot, count, now_s);
+}
+
+// Without the shared file the process id is the ticket, among the keys with a
+// positive weight when weighted (the parser guarantees there is one)
+static int fallback_key_index(int count, KeyPolicy policy, const int *weights) {
+    if (policy != KEY_POLICY_WEIGHTED) return (int)(getpid() % count);
+
+    int enabled = 0;
+    for (int i = 0; i < count; i++) {
+        if (weights[i] > 0) enabled++;
+    }
+    if (enabled == 0) return 0;
+
+    int ticket = (int)(getpid() % enabled);
+    for (int i = 0; i < count; i++) {
+        if (weights[i] > 0 && ticket-- == 0) return i;
+    }
+    return 0;
+}
+
+// Pick an index into a provider's key pool. Coordination across concurrently
+// launching processes happens through atomics in the shared key pool file;
+// without it, the process id spreads sessions instead.
+int select_key_index(const char *provider_name, int count, KeyPolicy policy, const int *weights) {
+    if (count <= 1) return 0;
+
+    KeyPoolState *state = attach_key_pool_state();
+    KeyPoolSlot *slot = state ? find_key_pool(state, provider_name) : NULL;
+    if (!slot) {
+        if (state) unmap_state_file(state, sizeof(KeyPoolState));
+        return fallback_key_index(count, policy, weights);
+    }
+
+    uint64_t now_us = wall_time_us();
+    uint64_t now_s = now_us / 1000000u;
+    int index;
+
+    switch (policy) {
+        case KEY_POLICY_LEAST_RECENTLY_USED:
+            index = select_least_recently_used(slot, count, now_s, now_us);
+            break;
+        case KEY_POLICY_WEIGHTED:
+            index = select_weighted(slot, count, weights, now_s);
+            break;
+        case KEY_POLICY_ROUND_ROBIN:
+        default:
+            index = select_round_robin(slot, count, now_s);
+            break;
+    }
+
+    if (policy != KEY_POLICY_LEAST_RECENTLY_USED) {
+        __atomic_store_n(&slot->last_used[index], now_us, __ATOMIC_RELAXED);
+    }
+
+    unmap_state_file(state, sizeof(KeyPoolState));
+    return index;
+}
+
+int select_api_key(const ProviderConfig *provider) {
+    return select_key_index(provider->name, provider->api_key_count,
+                            provider->key_policy, provider->key_weights);
+}
+
+// Mark a throttled key so selection skips it until the cooldown expires
+int run_cooldown_command(const CliOptions *options) {
+    char provider_name[MAX_PROVIDER_NAME];
+    long key_index = -1;
+    long seconds = DEFAULT_COOLDOWN_SECONDS;
+    int opt;
+
+    static struct option long_options[] = {
+        {"provider", required_argument, 0, 'p'},
+        {"key",      required_argument, 0, 'k'},
+        {"seconds",  required_argument, 0, 's'},
+        {0, 0, 0, 0}
+    };
+
+    strncpy(provider_name, options->provider, MAX_PROVIDER_NAME - 1);
+    provider_name[MAX_PROVIDER_NAME - 1] = '\0';
+
+    reset_option_parser();
+    while ((opt = getopt_long(options->command_argc, options->command_argv, "p:k:s:", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'p':
+                strncpy(provider_name, optarg, MAX_PROVIDER_NAME - 1);
+                provider_name[MAX_PROVIDER_NAME - 1] = '\0';
+                break;
+            case 'k':
+                if (!parse_long_argument(optarg, 0, MAX_API_KEYS - 1, &key_index)) {
+                    fprintf(stderr, "Error: Invalid key index '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case 's':
+                if (!parse_long_argument(optarg, 1, MAX_COOLDOWN_SECONDS, &seconds)) {
+                    fprintf(stderr, "Error: Invalid cooldown '%s', use 1 to %d seconds\n",
+                            optarg, MAX_COOLDOWN_SECONDS);
+                    return 1;
+                }
+                break;
+            default:
+                fprintf(stderr, "Usage: router-switch cooldown -p <provider> [--key <n>] [--seconds <s>]\n");
+                return 1;
+        }
+    }
+
+    if (strlen(provider_name) == 0) {
+        fprintf(stderr, "Error: Provider must be specified with --provider or -p\n");
+        return 1;
+    }
+
+    Config config;
+    if (!load_config(resolve_config_path(options), &config) || !validate_provider_and_model(&config, provider_name, NULL)) {
+        return 1;
+    }
+
+    ProviderConfig *provider = find_provider(&config, provider_name);
+    if (provider->api_key_count == 0) {
+        fprintf(stderr, "Error: Provider '%s' has no api_keys pool\n", provider_name);
+        return 1;
+    }
+
+    // Default to the key exported into this shell by the last switch
+    if (key_index < 0) {
+        const char *current_key = getenv("ANTHROPIC_AUTH_TOKEN");
+        for (int i = 0; current_key && i < provider->api_key_count; i++) {
+            if (strcmp(provider->api_keys[i], current_key) == 0) {
+                key_index = i;
+                break;
+            }
+        }
+        if (key_index < 0) {
+            fprintf(stderr, "Error: Current ANTHROPIC_AUTH_TOKEN is not in the pool of '%s', use --key\n",
+                    provider_name);
+            return 1;
+        }
+    }
+
+    if (key_index >= provider->api_key_count) {
+        fprintf(stderr, "Error: Key index must be between 0 and %d\n", provider->api_key_count - 1);
+        return 1;
+    }
+
+    KeyPoolState *state = attach_key_pool_state();
+    KeyPoolSlot *slot = state ? find_key_pool(state, provider_name) : NULL;
+    if (!slot) {
+        fprintf(stderr, "Error: Failed to open key pool state\n");
+        if (state) unmap_state_file(state, sizeof(KeyPoolState));
+        return 1;
+    }
+
+    uint64_t until = wall_time_us() / 1000000u + (uint64_t)seconds;
+    __atomic_store_n(&slot->cooldown_until[key_index], until, __ATOMIC_RELAXED);
+    unmap_state_file(state, sizeof(KeyPoolState));
+
+    printf("Key #%ld of provider '%s' cooling down for %lds\n", key_index, provider_name, seconds);
+    return 0;
+}
@@ -0,0 +1,229 @@
+// router-switch-lite: switch-only entry point built for cold-start latency
+// (`make lite`). It is linked statically, writes its output with a single
+// write(2) and scans argv by hand instead of using getopt_long. Only the
+// plain switch (-p/-m/-c/-v) is handled here; anything else - help,
+// --install, --global, subcommands, unknown flags and every error - is
+// handed to the full router-switch binary next to it via exec, so output
+// and exit codes stay identical.
+
+#include "router-switch.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#define LITE_OUTPUT_SIZE 65536
+#define FULL_BINARY_NAME "router-switch"
+
+static char output[LITE_OUTPUT_SIZE];
+static size_t output_length;
+static int output_overflow;
+
+static void append_text(const char *text) {
+    size_t len = strlen(text);
+    if (output_length + len >= sizeof(output)) {
+        output_overflow = 1;
+        return;
+    }
+    memcpy(output + output_length, text, len);
+    output_length += len;
+}
+
+static void append_unset(const char *name) {
+    append_text("unset ");
+    append_text(name);
+    append_text("\n");
+}
+
+static void append_export(const char *name, const char *value) {
+    char *escaped = shell_escape(value);
+    if (!escaped) {
+        output_overflow = 1;
+        return;
+    }
+    append_text("export ");
+    append_text(name);
+    append_text("=");
+    append_text(escaped);
+    append_text("\n");
+    free(escaped);
+}
+
+static int write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        data += written;
+        len -= (size_t)written;
+    }
+    return 1;
+}
+
+// Replace this process with the full binary, passing argv through unchanged
+static int exec_full_binary(char *argv[]) {
+    static char path[MAX_CONFIG_PATH];
+    const char *self = argv[0];
+    ssize_t len = -1;
+
+#ifdef __linux__
+    len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+#endif
+    if (len < 0) {
+        len = (ssize_t)strlen(self);
+        if (len >= (ssize_t)sizeof(path)) len = 0;
+        memcpy(path, self, (size_t)len);
+    }
+    path[len] = '\0';
+
+    // Refuse to exec ourselves if the lite binary was installed under the full name
+    char *slash = strrchr(path, '/');
+    const char *base = slash ? slash + 1 : path;
+    if (strcmp(base, FULL_BINARY_NAME) != 0) {
+        if (slash && (size_t)(slash + 1 - path) + sizeof(FULL_BINARY_NAME) <= sizeof(path)) {
+            memcpy(slash + 1, FULL_BINARY_NAME, sizeof(FULL_BINARY_NAME));
+            execv(path, argv);
+        } else {
+            execvp(FULL_BINARY_NAME, argv);
+        }
+    }
+
+    const char *message = "router-switch-lite: cannot run " FULL_BINARY_NAME " for this command\n";
+    write_all(STDERR_FILENO, message, strlen(message));
+    return 1;
+}
+
+// Match "-x value", "-xvalue", "--long value" and "--long=value"; advances *index
+static const char* option_value(int argc, char *argv[], int *index, char short_name, const char *long_name) {
+    const char *arg = argv[*index];
+
+    if (arg[0] == '-' && arg[1] == short_name) {
+        if (arg[2] != '\0') return arg + 2;
+    } else if (arg[0] == '-' && arg[1] == '-' && strncmp(arg + 2, long_name, strlen(long_name)) == 0) {
+        const char *rest = arg + 2 + strlen(long_name);
+        if (*rest == '=') return rest + 1;
+        if (*rest != '\0') return NULL;
+    } else {
+        return NULL;
+    }
+
+    if (*index + 1 >= argc) return NULL;
+    return argv[++*index];
+}
+
+// Read the whole config into a NUL-terminated buffer
+static char* read_config(const char *path) {
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    char *content = NULL;
+    if (fstat(fd, &st) == 0 && (content = malloc((size_t)st.st_size + 1)) != NULL) {
+        size_t total = 0;
+        while (total < (size_t)st.st_size) {
+            ssize_t got = read(fd, content + total, (size_t)st.st_size - total);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) break;
+            total += (size_t)got;
+        }
+        content[total] = '\0';
+    }
+    close(fd);
+    return content;
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t start_us = monotonic_time_us();
+    static ProviderConfig provider;
+    static ProviderConfig previous;
+    const char *provider_name = NULL;
+    const char *model_name = NULL;
+    const char *config_path = DEFAULT_CONFIG_PATH;
+    int verbose = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value;
+        if ((value = option_value(argc, argv, &i, 'p', "provider")) != NULL) {
+            provider_name = value;
+        } else if ((value = option_value(argc, argv, &i, 'm', "model")) != NULL) {
+            model_name = value;
+        } else if ((value = option_value(argc, argv, &i, 'c', "config")) != NULL) {
+            config_path = value;
+        } else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
+            verbose = 1;
+        } else {
+            return exec_full_binary(argv);
+        }
+    }
+
+    // Same truncation as the CliOptions buffers of the full binary
+    if (!provider_name || !*provider_name || strlen(provider_name) >= MAX_PROVIDER_NAME ||
+        (model_name && strlen(model_name) >= MAX_MODEL_NAME) || strlen(config_path) >= MAX_CONFIG_PATH) {
+        return exec_full_binary(argv);
+    }
+    if (model_name && !*model_name) {
+        model_name = NULL;
+    }
+
+    char *content = read_config(config_path);
+    if (!content || !parse_config_provider(content, provider_name, &provider)) {
+        return exec_full_binary(argv);
+    }
+
+    int model_index = 0;
+    if (model_name && provider.model_count > 0) {
+        while (model_index < provider.model_count && strcmp(provider.models[model_index], model_name) != 0) {
+            model_index++;
+        }
+        if (model_index == provider.model_count) {
+            return exec_full_binary(argv);
+        }
+    }
+
+    // Clear the current provider, as clear_provider_environment does
+    const char *current_provider = getenv("ROUTERSWITCH_CURRENT_PROVIDER");
+    if (current_provider) {
+        if (parse_config_provider(content, current_provider, &previous)) {
+            append_unset("ANTHROPIC_BASE_URL");
+            append_unset("ANTHROPIC_AUTH_TOKEN");
+            append_unset("ANTHROPIC_MODEL");
+            for (int i = 0; i < previous.env_count; i++) {
+                append_unset(previous.env_names[i]);
+            }
+            append_unset("ROUTERSWITCH_CURRENT_PROVIDER");
+        } else if (verbose) {
+            const char *message = "Warning: Failed to clear environment for provider '";
+            write_all(STDERR_FILENO, message, strlen(message));
+            write_all(STDERR_FILENO, current_provider, strlen(current_provider));
+            write_all(STDERR_FILENO, "'\n", 2);
+        }
+    }
+    free(content);
+
+    // Apply the new one, as apply_provider_environment does
+    append_export("ANTHROPIC_BASE_URL", provider.base_url);
+    if (provider.api_key_count > 0) {
+        append_export("ANTHROPIC_AUTH_TOKEN", provider.api_keys[select_api_key(&provider)]);
+    } else {
+        append_export("ANTHROPIC_AUTH_TOKEN", provider.api_key);
+    }
+    if (provider.model_count > 0) {
+        append_export("ANTHROPIC_MODEL", provider.models[model_index]);
+    }
+    for (int i = 0; i < provider.env_count; i++) {
+        append_export(provider.env_names[i], provider.env_values[i]);
+    }
+    append_export("ROUTERSWITCH_CURRENT_PROVIDER", provider_name);
+
+    if (output_overflow) {
+        return exec_full_binary(argv);
+    }
+    if (!write_all(STDOUT_FILENO, output, output_length)) {
+        return 1;
+    }
+
+    record_switch_event(provider.name, provider.model_count > 0 ? provider.models[model_index] : model_name,
+                        start_us);
+    return 0;
+}
@@ -1,9 +1,9 @@
 #include "router-switch.h"
 
 int main(int argc, char *argv[]) {
+    uint64_t start_us = monotonic_time_us();
     CliOptions options = {0};
     Config config = {0};
-    char *current_provider = NULL;
 
     // Parse command line arguments
     parse_command_line_args(argc, argv, &options);
@@ -19,11 +19,17 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
+    // Many concurrent starts attach one published copy instead of parsing
+    const char *shared_config = getenv("ROUTERSWITCH_SHARED_CONFIG");
+    if (shared_config && *shared_config && strcmp(shared_config, "0") != 0) {
+        options.shared = 1;
+    }
+
     // Handle install flag
     if (options.install) {
         // Load configuration to get provider list for completion
-        const char *config_path = strlen(options.config_path) > 0 ? options.config_path : "config.json";
-        if (!load_config(config_path, &config)) {
+        const char *config_path = resolve_config_path(&options);
+        if (!(options.shared ? load_shared_config(config_path, &config) : load_config(config_path, &config))) {
             return 1;
         }
 
@@ -32,15 +38,52 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
+    // Handle subcommands
+    if (strlen(options.command) > 0) {
+        if (strcmp(options.command, "stats") == 0) {
+            return run_stats_command(&options);
+        }
+        if (strcmp(options.command, "cooldown") == 0) {
+            return run_cooldown_command(&options);
+        }
+        if (strcmp(options.command, "mock-server") == 0) {
+            return run_mock_server_command(&options);
+        }
+        if (strcmp(options.command, "publish") == 0) {
+            return run_publish_command(&options);
+        }
+        if (strcmp(options.command, "forward") == 0) {
+            return run_forward_command(&options);
+        }
+        if (strcmp(options.command, "replay") == 0) {
+            return run_replay_command(&options);
+        }
+        if (strcmp(options.command, "sync") == 0) {
+            return run_sync_command(&options, start_us);
+        }
+        fprintf(stderr, "Error: Unknown command '%s'. Use --help for usage information.\n", options.command);
+        return 1;
+    }
+
     // Validate that provider is specified
     if (strlen(options.provider) == 0) {
         fprintf(stderr, "Error: Provider must be specified with --provider or -p\n");
         return 1;
     }
 
+#ifdef ROUTER_SWITCH_EMBEDDED
+    // Built-in provider tables: resolve the switch without file I/O or parsing
+    if (strlen(options.config_path) == 0) {
+        if (embedded_switch(&options, start_us) != 0) {
+            return 1;
+        }
+        return options.global ? publish_global_switch(&options) : 0;
+    }
+#endif
+
     // Load configuration
-    const char *config_path = strlen(options.config_path) > 0 ? options.config_path : "config.json";
-    if (!load_config(config_path, &config)) {
+    const char *config_path = resolve_config_path(&options);
+    if (!(options.shared ? load_shared_config(config_path, &config) : load_config(config_path, &config))) {
         return 1;
     }
 
@@ -50,25 +93,21 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
-    // Get current provider
-    current_provider = get_current_provider();
-
-    // Clear environment variables for current provider (if any)
-    if (current_provider != NULL) {
-        if (!clear_provider_environment(&config, current_provider)) {
-            if (options.verbose) {
-                fprintf(stderr, "Warning: Failed to clear environment for provider '%s'\n", current_provider);
-            }
-            // Don't return here, continue with setting new provider
-        }
-        free(current_provider);
+    // Clear the current provider and set the new one
+    if (!switch_provider_environment(&config, options.provider,
+                                     strlen(options.model) > 0 ? options.model : NULL, options.verbose)) {
+        return 1;
     }
 
-    // Set environment variables for new provider
-    if (!apply_provider_environment(&config, options.provider,
-                                   strlen(options.model) > 0 ? options.model : NULL)) {
-        fprintf(stderr, "Error: Failed to set environment for provider '%s'\n", options.provider);
-        return 1;
+    // Record the switch for the stats command
+    ProviderConfig *provider = find_provider(&config, options.provider);
+    const char *model = strlen(options.model) > 0 ? options.model :
+                        (provider->model_count > 0 ? provider->models[0] : NULL);
+    record_switch_event(options.provider, model, start_us);
+
+    // Broadcast to the other shells of this user
+    if (options.global) {
+        return publish_global_switch(&options);
     }
 
     // Success
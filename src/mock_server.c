@@ -0,0 +1,721 @@
+#include "router-switch.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+// Local stand-in for Anthropic-compatible providers. Each selected provider
+// gets its own port; requests must carry one of the provider's keys and are
+// answered with canned JSON or SSE streams after a configurable delay.
+
+#define MOCK_DEFAULT_PORT 8787
+#define MOCK_MAX_REQUEST (4 * 1024 * 1024)
+#define MOCK_MAX_HEADERS (64 * 1024)
+#define MOCK_READ_CHUNK 16384
+#define MOCK_MAX_EVENTS 1024
+#define MOCK_MAX_CHUNKS 100000
+
+enum {
+    MOCK_LISTENER = 0,   // LoopHandle kinds
+    MOCK_CONNECTION
+};
+
+enum {
+    MOCK_READING = 0,    // waiting for a complete request
+    MOCK_WAITING,        // request accepted, response delayed by the latency timer
+    MOCK_STREAMING,      // SSE response in progress, next delta scheduled
+    MOCK_FINISHING       // whole response queued, flushing
+};
+
+typedef struct {
+    int latency_ms;
+    int jitter_ms;
+    double tail_rate;
+    int tail_ms;
+    double error_rate;
+    int force_stream;
+    int chunks;
+    int chunk_interval_ms;
+    int verbose;
+} MockOptions;
+
+typedef struct {
+    LoopHandle handle;                // MOCK_LISTENER
+    int fd;
+    int port;
+    const ProviderConfig *provider;
+    char path_prefix[MAX_URL_PATH];
+    uint64_t requests;
+    uint64_t auth_failures;
+    uint64_t injected_errors;
+    uint64_t not_found;
+} MockListener;
+
+typedef struct MockConnection {
+    LoopHandle handle;                // MOCK_CONNECTION
+    int fd;
+    uint64_t generation;              // bumped on reuse, stale timers carry an old tag
+    MockListener *listener;
+    int state;
+    int keep_alive;
+    int stream;
+    int status;
+    int chunks_left;
+    uint64_t message_id;
+    char model[MAX_MODEL_NAME];
+    char *in;
+    size_t in_len;
+    size_t in_cap;
+    char *out;
+    size_t out_len;
+    size_t out_sent;
+    size_t out_cap;
+    int want_write;
+    struct MockConnection *next_free;
+} MockConnection;
+
+typedef struct {
+    EventLoop *loop;
+    MockOptions options;
+    MockListener listeners[MAX_PROVIDERS];
+    int listener_count;
+    MockConnection *free_connections;
+    uint64_t random_state;
+    uint64_t next_message_id;
+    int active_connections;
+    int peak_connections;
+    int max_fds;
+} MockServer;
+
+static volatile sig_atomic_t mock_stop_requested = 0;
+
+static void handle_stop_signal(int sig) {
+    (void)sig;
+    mock_stop_requested = 1;
+}
+
+static uint64_t next_random(MockServer *server) {
+    // xorshift64*
+    uint64_t x = server->random_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    server->random_state = x;
+    return x * 2685821657736338717ull;
+}
+
+static double random_unit(MockServer *server) {
+    return (double)(next_random(server) >> 11) / 9007199254740992.0;
+}
+
+static int append_output(MockConnection *conn, const char *format, ...) {
+    for (;;) {
+        va_list args;
+        size_t available = conn->out_cap - conn->out_len;
+
+        va_start(args, format);
+        int written = vsnprintf(conn->out + conn->out_len, available, format, args);
+        va_end(args);
+
+        if (written < 0) return 0;
+        if ((size_t)written < available) {
+            conn->out_len += (size_t)written;
+            return 1;
+        }
+
+        size_t capacity = conn->out_cap ? conn->out_cap * 2 : 4096;
+        while (capacity - conn->out_len <= (size_t)written) capacity *= 2;
+        char *out = realloc(conn->out, capacity);
+        if (!out) return 0;
+        conn->out = out;
+        conn->out_cap = capacity;
+    }
+}
+
+// One HTTP/1.1 chunk holding one SSE event
+static void append_sse_event(MockConnection *conn, const char *event, const char *data) {
+    int length = snprintf(NULL, 0, "event: %s\ndata: %s\n\n", event, data);
+    append_output(conn, "%x\r\nevent: %s\ndata: %s\n\n\r\n", length, event, data);
+}
+
+static MockConnection* acquire_connection(MockServer *server) {
+    MockConnection *conn = server->free_connections;
+    if (conn) {
+        server->free_connections = conn->next_free;
+    } else {
+        conn = calloc(1, sizeof(MockConnection));
+        if (!conn) return NULL;
+    }
+    conn->handle.kind = MOCK_CONNECTION;
+    conn->generation++;
+    conn->state = MOCK_READING;
+    conn->in_len = 0;
+    conn->out_len = 0;
+    conn->out_sent = 0;
+    conn->want_write = 0;
+    conn->next_free = NULL;
+    return conn;
+}
+
+// Connections are recycled, never freed, so pending timers can always check their tag
+static void close_connection(MockServer *server, MockConnection *conn) {
+    event_loop_remove(server->loop, conn->fd);
+    close(conn->fd);
+    conn->fd = -1;
+    conn->generation++;
+    conn->next_free = server->free_connections;
+    server->free_connections = conn;
+    server->active_connections--;
+}
+
+static void process_input(MockServer *server, MockConnection *conn);
+
+// Write as much pending output as the socket takes; returns 0 if the connection was closed
+static int flush_output(MockServer *server, MockConnection *conn) {
+    while (conn->out_sent < conn->out_len) {
+        ssize_t sent = send(conn->fd, conn->out + conn->out_sent, conn->out_len - conn->out_sent, 0);
+        if (sent > 0) {
+            conn->out_sent += (size_t)sent;
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!conn->want_write) {
+                conn->want_write = 1;
+                event_loop_modify(server->loop, conn->fd, LOOP_READ | LOOP_WRITE, conn);
+            }
+            return 1;
+        }
+        close_connection(server, conn);
+        return 0;
+    }
+
+    conn->out_len = 0;
+    conn->out_sent = 0;
+    if (conn->want_write) {
+        conn->want_write = 0;
+        event_loop_modify(server->loop, conn->fd, LOOP_READ, conn);
+    }
+
+    if (conn->state == MOCK_FINISHING) {
+        if (!conn->keep_alive) {
+            close_connection(server, conn);
+            return 0;
+        }
+        conn->state = MOCK_READING;
+        process_input(server, conn);    // pipelined requests already buffered
+        return conn->fd >= 0;
+    }
+    return 1;
+}
+
+static void respond_immediately(MockServer *server, MockConnection *conn, int status,
+                                const char *reason, const char *error_type, const char *message) {
+    char body[512];
+    int length = snprintf(body, sizeof(body),
+                          "{\"type\":\"error\",\"error\":{\"type\":\"%s\",\"message\":\"%s\"}}",
+                          error_type, message);
+
+    append_output(conn, "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\n"
+                  "Content-Length: %d\r\nConnection: %s\r\n\r\n%s",
+                  status, reason, length, conn->keep_alive ? "keep-alive" : "close", body);
+    conn->state = MOCK_FINISHING;
+    flush_output(server, conn);
+}
+
+static int token_is_valid(const ProviderConfig *provider, const char *token) {
+    if (provider->api_key_count == 0) {
+        return strcmp(provider->api_key, token) == 0;
+    }
+    for (int i = 0; i < provider->api_key_count; i++) {
+        if (strcmp(provider->api_keys[i], token) == 0) return 1;
+    }
+    return 0;
+}
+
+static void send_delayed_response(MockServer *server, MockConnection *conn) {
+    const char *provider_name = conn->listener->provider->name;
+    const char *connection = conn->keep_alive ? "keep-alive" : "close";
+
+    if (conn->status != 200) {
+        respond_immediately(server, conn, conn->status, "Overloaded", "overloaded_error",
+                            "Mock server injected error");
+        return;
+    }
+
+    if (!conn->stream) {
+        char body[2048];
+        int length = snprintf(body, sizeof(body),
+            "{\"id\":\"msg_mock_%llu\",\"type\":\"message\",\"role\":\"assistant\",\"model\":\"%s\","
+            "\"content\":[{\"type\":\"text\",\"text\":\"Mock response from %s\"}],"
+            "\"stop_reason\":\"end_turn\",\"stop_sequence\":null,"
+            "\"usage\":{\"input_tokens\":10,\"output_tokens\":%d}}",
+            (unsigned long long)conn->message_id, conn->model, provider_name, server->options.chunks);
+        append_output(conn, "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                      "Content-Length: %d\r\nConnection: %s\r\n\r\n%s", length, connection, body);
+        conn->state = MOCK_FINISHING;
+        flush_output(server, conn);
+        return;
+    }
+
+    char data[1024];
+    append_output(conn, "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n"
+                  "Transfer-Encoding: chunked\r\nConnection: %s\r\n\r\n", connection);
+    snprintf(data, sizeof(data),
+             "{\"type\":\"message_start\",\"message\":{\"id\":\"msg_mock_%llu\",\"type\":\"message\","
+             "\"role\":\"assistant\",\"model\":\"%s\",\"content\":[],\"stop_reason\":null,"
+             "\"stop_sequence\":null,\"usage\":{\"input_tokens\":10,\"output_tokens\":1}}}",
+             (unsigned long long)conn->message_id, conn->model);
+    append_sse_event(conn, "message_start", data);
+    append_sse_event(conn, "content_block_start",
+                     "{\"type\":\"content_block_start\",\"index\":0,\"content_block\":{\"type\":\"text\",\"text\":\"\"}}");
+    conn->chunks_left = server->options.chunks;
+    conn->state = MOCK_STREAMING;
+}
+
+// Queue the next SSE delta(s); with no chunk interval the whole stream goes out at once
+static void continue_stream(MockServer *server, MockConnection *conn) {
+    char data[512];
+
+    do {
+        if (conn->chunks_left > 0) {
+            snprintf(data, sizeof(data),
+                     "{\"type\":\"content_block_delta\",\"index\":0,"
+                     "\"delta\":{\"type\":\"text_delta\",\"text\":\"mock %s \"}}",
+                     conn->listener->provider->name);
+            append_sse_event(conn, "content_block_delta", data);
+            conn->chunks_left--;
+        }
+    } while (conn->chunks_left > 0 && server->options.chunk_interval_ms == 0);
+
+    if (conn->chunks_left == 0) {
+        append_sse_event(conn, "content_block_stop", "{\"type\":\"content_block_stop\",\"index\":0}");
+        snprintf(data, sizeof(data),
+                 "{\"type\":\"message_delta\",\"delta\":{\"stop_reason\":\"end_turn\",\"stop_sequence\":null},"
+                 "\"usage\":{\"output_tokens\":%d}}", server->options.chunks);
+        append_sse_event(conn, "message_delta", data);
+        append_sse_event(conn, "message_stop", "{\"type\":\"message_stop\"}");
+        append_output(conn, "0\r\n\r\n");
+        conn->state = MOCK_FINISHING;
+        flush_output(server, conn);
+        return;
+    }
+
+    if (flush_output(server, conn)) {
+        event_loop_add_timer(server->loop,
+                             monotonic_time_us() + (uint64_t)server->options.chunk_interval_ms * 1000u,
+                             conn, conn->generation);
+    }
+}
+
+static void handle_request(MockServer *server, MockConnection *conn, size_t header_length, size_t total_length) {
+    MockListener *listener = conn->listener;
+    char method[16] = "";
+    char path[MAX_URL_PATH] = "";
+    char version[16] = "";
+    char value[MAX_ENV_VAR_VALUE];
+    char token[MAX_ENV_VAR_VALUE] = "";
+
+    sscanf(conn->in, "%15s %511s %15s", method, path, version);
+    char *query = strchr(path, '?');
+    if (query) *query = '\0';
+
+    conn->keep_alive = strcmp(version, "HTTP/1.1") == 0;
+    if (http_header_value(conn->in, header_length, "Connection", value, sizeof(value))) {
+        if (strcasecmp(value, "close") == 0) conn->keep_alive = 0;
+        else if (strcasecmp(value, "keep-alive") == 0) conn->keep_alive = 1;
+    }
+
+    // Claude Code sends the token as a bearer token, the Anthropic SDKs as x-api-key
+    if (http_header_value(conn->in, header_length, "x-api-key", value, sizeof(value))) {
+        snprintf(token, sizeof(token), "%s", value);
+    } else if (http_header_value(conn->in, header_length, "Authorization", value, sizeof(value)) &&
+               strncasecmp(value, "Bearer ", 7) == 0) {
+        snprintf(token, sizeof(token), "%s", value + 7);
+    }
+
+    // Body as a C string for the JSON helpers (the buffer always has spare capacity)
+    char saved = conn->in[total_length];
+    conn->in[total_length] = '\0';
+    char *model = extract_json_string(conn->in + header_length, "model");
+    conn->stream = server->options.force_stream || extract_json_bool(conn->in + header_length, "stream", 0);
+    conn->in[total_length] = saved;
+
+    strncpy(conn->model, model ? model : "mock-model", MAX_MODEL_NAME - 1);
+    conn->model[MAX_MODEL_NAME - 1] = '\0';
+    free(model);
+
+    // Consume the request, keeping any pipelined bytes
+    memmove(conn->in, conn->in + total_length, conn->in_len - total_length);
+    conn->in_len -= total_length;
+
+    listener->requests++;
+    if (server->options.verbose) {
+        fprintf(stderr, "[%s] %s %s model=%s stream=%d\n", listener->provider->name,
+                method, path, conn->model, conn->stream);
+    }
+
+    size_t prefix_len = strlen(listener->path_prefix);
+    size_t path_len = strlen(path);
+    size_t suffix_len = strlen("/v1/messages");
+    if (strcmp(method, "POST") != 0 || strncmp(path, listener->path_prefix, prefix_len) != 0 ||
+        path_len < suffix_len || strcmp(path + path_len - suffix_len, "/v1/messages") != 0) {
+        listener->not_found++;
+        respond_immediately(server, conn, 404, "Not Found", "not_found_error", "Unknown endpoint");
+        return;
+    }
+
+    if (!token_is_valid(listener->provider, token)) {
+        listener->auth_failures++;
+        respond_immediately(server, conn, 401, "Unauthorized", "authentication_error",
+                            "Token does not match the provider's api_key");
+        return;
+    }
+
+    conn->status = 200;
+    if (server->options.error_rate > 0 && random_unit(server) < server->options.error_rate) {
+        conn->status = 529;
+        listener->injected_errors++;
+    }
+    conn->message_id = ++server->next_message_id;
+
+    // Delay the whole response by latency +/- jitter, plus the tail delay for a fraction of requests
+    int64_t delay_ms = server->options.latency_ms;
+    if (server->options.jitter_ms > 0) {
+        delay_ms += (int64_t)(next_random(server) % (uint64_t)(2 * server->options.jitter_ms + 1)) -
+                    server->options.jitter_ms;
+    }
+    if (server->options.tail_rate > 0 && random_unit(server) < server->options.tail_rate) {
+        delay_ms += server->options.tail_ms;
+    }
+    if (delay_ms < 0) delay_ms = 0;
+
+    conn->state = MOCK_WAITING;
+    if (delay_ms == 0) {
+        send_delayed_response(server, conn);
+        if (conn->fd >= 0 && conn->state == MOCK_STREAMING) continue_stream(server, conn);
+        return;
+    }
+    event_loop_add_timer(server->loop, monotonic_time_us() + (uint64_t)delay_ms * 1000u,
+                         conn, conn->generation);
+}
+
+// Parse as many complete requests as are buffered (one at a time, in order)
+static void process_input(MockServer *server, MockConnection *conn) {
+    while (conn->fd >= 0 && conn->state == MOCK_READING && conn->in_len > 0) {
+        size_t header_length = http_header_length(conn->in, conn->in_len);
+        if (header_length == 0) {
+            if (conn->in_len > MOCK_MAX_HEADERS) {
+                conn->keep_alive = 0;
+                respond_immediately(server, conn, 431, "Request Header Fields Too Large",
+                                    "invalid_request_error", "Headers too large");
+            }
+            return;
+        }
+
+        char value[32];
+        size_t body_length = 0;
+        if (http_header_value(conn->in, header_length, "Content-Length", value, sizeof(value))) {
+            body_length = (size_t)strtoul(value, NULL, 10);
+        }
+        if (header_length + body_length > MOCK_MAX_REQUEST) {
+            conn->keep_alive = 0;
+            respond_immediately(server, conn, 413, "Payload Too Large",
+                                "invalid_request_error", "Request too large");
+            return;
+        }
+        if (conn->in_len < header_length + body_length) {
+            return;
+        }
+
+        handle_request(server, conn, header_length, header_length + body_length);
+    }
+}
+
+static void handle_readable(MockServer *server, MockConnection *conn) {
+    for (;;) {
+        if (conn->in_cap - conn->in_len < MOCK_READ_CHUNK + 1) {
+            size_t capacity = conn->in_cap ? conn->in_cap * 2 : MOCK_READ_CHUNK * 2;
+            if (capacity > MOCK_MAX_REQUEST * 2) {
+                close_connection(server, conn);
+                return;
+            }
+            char *in = realloc(conn->in, capacity);
+            if (!in) {
+                close_connection(server, conn);
+                return;
+            }
+            conn->in = in;
+            conn->in_cap = capacity;
+        }
+
+        ssize_t received = recv(conn->fd, conn->in + conn->in_len, conn->in_cap - conn->in_len - 1, 0);
+        if (received > 0) {
+            conn->in_len += (size_t)received;
+            continue;
+        }
+        if (received < 0 && errno == EINTR) continue;
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        close_connection(server, conn);   // peer closed or reset
+        return;
+    }
+    process_input(server, conn);
+}
+
+static void accept_connections(MockServer *server, MockListener *listener) {
+    for (;;) {
+        int fd = accept(listener->fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return;  // EAGAIN, or out of descriptors until some close
+        }
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        MockConnection *conn = fd < server->max_fds && set_nonblocking(fd) ? acquire_connection(server) : NULL;
+        if (!conn) {
+            close(fd);
+            continue;
+        }
+
+        conn->fd = fd;
+        conn->listener = listener;
+        if (!event_loop_add(server->loop, fd, LOOP_READ, conn)) {
+            close(fd);
+            conn->fd = -1;
+            conn->next_free = server->free_connections;
+            server->free_connections = conn;
+            continue;
+        }
+        if (++server->active_connections > server->peak_connections) {
+            server->peak_connections = server->active_connections;
+        }
+    }
+}
+
+static void handle_timer(MockServer *server, MockConnection *conn, uint64_t tag) {
+    if (conn->generation != tag || conn->fd < 0) return;
+
+    if (conn->state == MOCK_WAITING) {
+        send_delayed_response(server, conn);
+        if (conn->fd >= 0 && conn->state == MOCK_STREAMING) continue_stream(server, conn);
+    } else if (conn->state == MOCK_STREAMING) {
+        continue_stream(server, conn);
+    }
+}
+
+static int parse_mock_options(const CliOptions *options, MockOptions *mock, char providers[][MAX_PROVIDER_NAME],
+                              int *provider_count, char *bind_address, int *port) {
+    int opt;
+    long number;
+
+    static struct option long_options[] = {
+        {"provider",          required_argument, 0, 'p'},
+        {"bind",              required_argument, 0, 'b'},
+        {"port",              required_argument, 0, 'P'},
+        {"latency-ms",        required_argument, 0, 'l'},
+        {"jitter-ms",         required_argument, 0, 'j'},
+        {"tail-rate",         required_argument, 0, 't'},
+        {"tail-ms",           required_argument, 0, 'T'},
+        {"error-rate",        required_argument, 0, 'e'},
+        {"stream",            no_argument,       0, 's'},
+        {"chunks",            required_argument, 0, 'n'},
+        {"chunk-interval-ms", required_argument, 0, 'I'},
+        {0, 0, 0, 0}
+    };
+
+    reset_option_parser();
+    while ((opt = getopt_long(options->command_argc, options->command_argv, "p:b:P:l:j:t:T:e:sn:I:",
+                              long_options, NULL)) != -1) {
+        int valid = 1;
+        switch (opt) {
+            case 'p':
+                if (!add_provider_argument(providers, provider_count, optarg)) return 0;
+                break;
+            case 'b':
+                strncpy(bind_address, optarg, MAX_HOST_NAME - 1);
+                bind_address[MAX_HOST_NAME - 1] = '\0';
+                break;
+            case 'P':
+                valid = parse_long_argument(optarg, 1, 65535, &number);
+                *port = (int)number;
+                break;
+            case 'l':
+                valid = parse_long_argument(optarg, 0, MAX_OPTION_MS, &number);
+                mock->latency_ms = (int)number;
+                break;
+            case 'j':
+                valid = parse_long_argument(optarg, 0, MAX_OPTION_MS, &number);
+                mock->jitter_ms = (int)number;
+                break;
+            case 't':
+                valid = parse_double_argument(optarg, 0, 1, &mock->tail_rate);
+                break;
+            case 'T':
+                valid = parse_long_argument(optarg, 0, MAX_OPTION_MS, &number);
+                mock->tail_ms = (int)number;
+                break;
+            case 'e':
+                valid = parse_double_argument(optarg, 0, 1, &mock->error_rate);
+                break;
+            case 's':
+                mock->force_stream = 1;
+                break;
+            case 'n':
+                valid = parse_long_argument(optarg, 1, MOCK_MAX_CHUNKS, &number);
+                mock->chunks = (int)number;
+                break;
+            case 'I':
+                valid = parse_long_argument(optarg, 0, MAX_OPTION_MS, &number);
+                mock->chunk_interval_ms = (int)number;
+                break;
+            default:
+                return 0;
+        }
+        if (!valid) {
+            fprintf(stderr, "Error: Invalid mock-server option value '%s'\n", optarg);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Serve the selected providers until interrupted, then print per-provider counts
+int run_mock_server_command(const CliOptions *options) {
+    static MockServer server;
+    static Config config;
+    char providers[MAX_PROVIDERS][MAX_PROVIDER_NAME];
+    char bind_address[MAX_HOST_NAME] = "127.0.0.1";
+    int provider_count = 0;
+    int port = MOCK_DEFAULT_PORT;
+
+    server.options.chunks = 8;
+    server.options.verbose = options->verbose;
+    if (strlen(options->provider) > 0) {
+        strcpy(providers[provider_count++], options->provider);
+    }
+
+    if (!parse_mock_options(options, &server.options, providers, &provider_count, bind_address, &port)) {
+        fprintf(stderr, "Usage: router-switch mock-server [-p <provider>]... [--bind <addr>] [--port <n>]\n"
+                        "         [--latency-ms <n>] [--jitter-ms <n>] [--tail-rate <0..1>] [--tail-ms <n>]\n"
+                        "         [--error-rate <0..1>] [--stream] [--chunks <n>] [--chunk-interval-ms <n>]\n");
+        return 1;
+    }
+
+    if (!load_config(resolve_config_path(options), &config)) {
+        return 1;
+    }
+
+    // Default to every configured provider
+    if (provider_count == 0) {
+        for (int i = 0; i < config.provider_count; i++) {
+            strcpy(providers[provider_count++], config.providers[i].name);
+        }
+    }
+
+    server.max_fds = raise_fd_limit();
+    server.loop = event_loop_create(server.max_fds);
+    server.random_state = (monotonic_time_us() ^ ((uint64_t)getpid() << 32)) | 1;
+    if (!server.loop) {
+        fprintf(stderr, "Error: Failed to create event loop\n");
+        return 1;
+    }
+
+    fprintf(stderr, "Mock server (latency %dms +/- %dms", server.options.latency_ms, server.options.jitter_ms);
+    if (server.options.tail_rate > 0) {
+        fprintf(stderr, ", +%dms for %g%%", server.options.tail_ms, server.options.tail_rate * 100);
+    }
+    fprintf(stderr, ", error rate %.2f, %s responses):\n", server.options.error_rate,
+            server.options.force_stream ? "streamed" : "requested");
+
+    for (int i = 0; i < provider_count; i++) {
+        if (!validate_provider_and_model(&config, providers[i], NULL)) {
+            return 1;
+        }
+
+        MockListener *listener = &server.listeners[server.listener_count];
+        char host[MAX_HOST_NAME];
+        int upstream_port;
+        listener->handle.kind = MOCK_LISTENER;
+        listener->provider = find_provider(&config, providers[i]);
+        listener->port = port + i;
+
+        // Serve under the same path as the real base_url so only host and port change
+        if (!parse_http_url(listener->provider->base_url, host, sizeof(host), &upstream_port,
+                            listener->path_prefix, sizeof(listener->path_prefix))) {
+            const char *scheme_end = strstr(listener->provider->base_url, "://");
+            const char *path = scheme_end ? strchr(scheme_end + 3, '/') : NULL;
+            snprintf(listener->path_prefix, sizeof(listener->path_prefix), "%s", path ? path : "");
+            size_t len = strlen(listener->path_prefix);
+            if (len > 0 && listener->path_prefix[len - 1] == '/') listener->path_prefix[len - 1] = '\0';
+        }
+
+        listener->fd = listen_tcp(bind_address, listener->port);
+        if (listener->fd < 0 || !event_loop_add(server.loop, listener->fd, LOOP_READ, listener)) {
+            fprintf(stderr, "Error: Failed to listen on %s:%d: %s\n", bind_address, listener->port, strerror(errno));
+            return 1;
+        }
+        server.listener_count++;
+
+        fprintf(stderr, "  %-20s http://%s:%d%s\n", listener->provider->name, bind_address,
+                listener->port, listener->path_prefix);
+    }
+    fprintf(stderr, "Press Ctrl-C to stop\n");
+
+    struct sigaction action = {0};
+    action.sa_handler = handle_stop_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    LoopEvent events[MOCK_MAX_EVENTS];
+    uint64_t started = monotonic_time_us();
+
+    while (!mock_stop_requested) {
+        int count = event_loop_wait(server.loop, events, MOCK_MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "Error: Event loop failed: %s\n", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (events[i].events & LOOP_TIMER) {
+                handle_timer(&server, events[i].data, events[i].tag);
+                continue;
+            }
+
+            if (((LoopHandle *)events[i].data)->kind == MOCK_LISTENER) {
+                accept_connections(&server, events[i].data);
+                continue;
+            }
+
+            MockConnection *conn = events[i].data;
+            if (conn->fd < 0) continue;
+            if ((events[i].events & LOOP_WRITE) && !flush_output(&server, conn)) {
+                continue;
+            }
+            if (events[i].events & (LOOP_READ | LOOP_ERROR)) {
+                handle_readable(&server, conn);
+            }
+        }
+    }
+
+    double elapsed = (double)(monotonic_time_us() - started) / 1e6;
+    fprintf(stderr, "\nMock server stopped after %.1fs (peak %d concurrent connections)\n",
+            elapsed, server.peak_connections);
+    fprintf(stderr, "%-20s %10s %10s %10s %10s\n", "Provider", "Requests", "Auth fail", "Errors", "Not found");
+    for (int i = 0; i < server.listener_count; i++) {
+        MockListener *listener = &server.listeners[i];
+        fprintf(stderr, "%-20s %10llu %10llu %10llu %10llu\n", listener->provider->name,
+                (unsigned long long)listener->requests, (unsigned long long)listener->auth_failures,
+                (unsigned long long)listener->injected_errors, (unsigned long long)listener->not_found);
+        close(listener->fd);
+    }
+
+    event_loop_destroy(server.loop);
+    return 0;
+}
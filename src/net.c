@@ -0,0 +1,164 @@
+#include "router-switch.h"
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <strings.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// Allow as many descriptors as the hard limit permits (thousands of connections)
+int raise_fd_limit(void) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return 1024;
+    }
+    if (limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+#ifdef __APPLE__
+        if (limit.rlim_cur > 10240) limit.rlim_cur = 10240; // OPEN_MAX
+#endif
+        setrlimit(RLIMIT_NOFILE, &limit);
+        getrlimit(RLIMIT_NOFILE, &limit);
+    }
+    return limit.rlim_cur > 1048576 ? 1048576 : (int)limit.rlim_cur;
+}
+
+static struct addrinfo* resolve_address(const char *host, int port, int passive) {
+    struct addrinfo hints = {0};
+    struct addrinfo *result = NULL;
+    char service[16];
+
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = passive ? AI_PASSIVE : 0;
+    snprintf(service, sizeof(service), "%d", port);
+
+    if (getaddrinfo(host, service, &hints, &result) != 0) {
+        return NULL;
+    }
+    return result;
+}
+
+// Create a non-blocking listening socket; returns the fd or -1
+int listen_tcp(const char *host, int port) {
+    struct addrinfo *addresses = resolve_address(host, port, 1);
+    int fd = -1;
+
+    for (struct addrinfo *ai = addresses; ai && fd < 0; ai = ai->ai_next) {
+        int one = 1;
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) != 0 || listen(fd, SOMAXCONN) != 0 ||
+            !set_nonblocking(fd)) {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    if (addresses) freeaddrinfo(addresses);
+    return fd;
+}
+
+// Start a non-blocking connect; completion is signalled by writability
+int connect_tcp(const char *host, int port) {
+    struct addrinfo *addresses = resolve_address(host, port, 0);
+    int fd = -1;
+
+    for (struct addrinfo *ai = addresses; ai && fd < 0; ai = ai->ai_next) {
+        int one = 1;
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) continue;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (!set_nonblocking(fd) ||
+            (connect(fd, ai->ai_addr, ai->ai_addrlen) != 0 && errno != EINPROGRESS)) {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    if (addresses) freeaddrinfo(addresses);
+    return fd;
+}
+
+// Split http://host[:port][/path] into its parts. https URLs are rejected:
+// there is no TLS support, put a TLS-terminating proxy in front instead.
+int parse_http_url(const char *url, char *host, size_t host_size, int *port, char *path, size_t path_size) {
+    const char *prefix = "http://";
+    if (strncmp(url, prefix, strlen(prefix)) != 0) {
+        return 0;
+    }
+
+    const char *start = url + strlen(prefix);
+    const char *path_start = strchr(start, '/');
+    const char *host_end = path_start ? path_start : start + strlen(start);
+    const char *colon = memchr(start, ':', (size_t)(host_end - start));
+
+    *port = 80;
+    if (colon) {
+        *port = atoi(colon + 1);
+        host_end = colon;
+    }
+
+    size_t host_len = (size_t)(host_end - start);
+    if (host_len == 0 || host_len >= host_size || *port <= 0 || *port > 65535) {
+        return 0;
+    }
+    memcpy(host, start, host_len);
+    host[host_len] = '\0';
+
+    // Drop a trailing slash so "<path>/v1/messages" joins cleanly
+    snprintf(path, path_size, "%s", path_start ? path_start : "");
+    size_t path_len = strlen(path);
+    if (path_len > 0 && path[path_len - 1] == '/') {
+        path[path_len - 1] = '\0';
+    }
+    return 1;
+}
+
+// Length of the header block including the blank line, or 0 if incomplete
+size_t http_header_length(const char *data, size_t len) {
+    for (size_t i = 3; i < len; i++) {
+        if (data[i] == '\n' && data[i - 1] == '\r' && data[i - 2] == '\n' && data[i - 3] == '\r') {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+// Case-insensitive lookup of a header value inside a header block
+int http_header_value(const char *head, size_t head_len, const char *name, char *value, size_t value_size) {
+    size_t name_len = strlen(name);
+    const char *end = head + head_len;
+    const char *line = memchr(head, '\n', head_len); // Skip the start line
+
+    while (line && line + 1 < end) {
+        line++;
+        const char *line_end = memchr(line, '\n', (size_t)(end - line));
+        if (!line_end) break;
+
+        if ((size_t)(line_end - line) > name_len && line[name_len] == ':' &&
+            strncasecmp(line, name, name_len) == 0) {
+            const char *v = line + name_len + 1;
+            while (v < line_end && isspace((unsigned char)*v)) v++;
+            const char *v_end = line_end;
+            while (v_end > v && isspace((unsigned char)v_end[-1])) v_end--;
+
+            size_t len = (size_t)(v_end - v);
+            if (len >= value_size) len = value_size - 1;
+            memcpy(value, v, len);
+            value[len] = '\0';
+            return 1;
+        }
+        line = line_end;
+    }
+    return 0;
+}
@@ -0,0 +1,709 @@
+#include "router-switch.h"
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <strings.h>
+#include <sys/socket.h>
+
+// Traffic replay: sends the request bodies of a recorded JSONL log to each
+// selected provider at the recorded inter-arrival times (or a fixed rate) and
+// reports throughput, time to first token and end-to-end latency per
+// provider and model. Each log line is an object such as
+//   {"offset_ms": 1250, "body": {"model": "...", "messages": [...], "stream": true}}
+// where offset_ms is the send time relative to the start of the recording.
+
+#define REPLAY_MAX_EVENTS 1024
+#define REPLAY_READ_CHUNK 16384
+#define REPLAY_DEFAULT_TIMEOUT_MS 300000
+#define REPLAY_MAX_LINE (16 * 1024 * 1024)
+#define REPLAY_MAX_RATE 1000000.0   // caps --rate (requests per second) and --speed
+
+enum {
+    REPLAY_DISPATCHER = 0,   // LoopHandle kinds
+    REPLAY_REQUEST
+};
+
+enum {
+    REPLAY_CONNECTING = 0,
+    REPLAY_SENDING,
+    REPLAY_RECEIVING
+};
+
+typedef struct {
+    uint64_t offset_us;
+    char *body;              // request body with the model value cut out
+    size_t model_start;      // where the model value was (body[model_start] is its slot)
+    int has_model;           // body had a model string, possibly empty
+    char model[MAX_MODEL_NAME];
+} ReplayEntry;
+
+typedef struct {
+    const ProviderConfig *provider;
+    char host[MAX_HOST_NAME];
+    int port;
+    char path[MAX_URL_PATH];
+} ReplayTarget;
+
+typedef struct {
+    int target;
+    char model[MAX_MODEL_NAME];
+    uint32_t *ttft_us;
+    uint32_t *e2e_us;
+    int completed;
+    int capacity;
+    int errors;
+    int timeouts;
+    uint64_t output_tokens;
+    uint64_t first_start_us;
+    uint64_t last_end_us;
+} ReplayGroup;
+
+typedef struct ReplayRequest {
+    LoopHandle handle;                 // REPLAY_REQUEST
+    int fd;
+    uint64_t generation;               // bumped on reuse, stale timers carry an old tag
+    int state;
+    int group;
+    char *out;
+    size_t out_len;
+    size_t out_sent;
+    size_t out_cap;
+    char *in;
+    size_t in_len;
+    size_t in_cap;
+    size_t header_length;
+    size_t scanned;                    // body bytes already searched for the first token
+    int status;
+    int chunked;
+    long content_length;
+    uint64_t start_us;
+    uint64_t first_token_us;
+    struct ReplayRequest *next_free;
+} ReplayRequest;
+
+typedef struct {
+    LoopHandle handle;                 // REPLAY_DISPATCHER
+    EventLoop *loop;
+    ReplayEntry *entries;
+    int entry_count;
+    int next_entry;
+    ReplayTarget targets[MAX_PROVIDERS];
+    int target_count;
+    ReplayGroup *groups;
+    int group_count;
+    int group_capacity;
+    ReplayRequest *free_requests;
+    int in_flight;
+    int max_fds;
+    double rate;
+    double speed;
+    int keep_model;
+    int timeout_ms;
+    uint64_t started_us;
+} ReplaySession;
+
+static volatile sig_atomic_t replay_stop_requested = 0;
+
+static void handle_stop_signal(int sig) {
+    (void)sig;
+    replay_stop_requested = 1;
+}
+
+// Read the log: one request per non-empty line
+static int load_replay_log(const char *path, ReplaySession *session) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Error: Failed to open replay log '%s': %s\n", path, strerror(errno));
+        return 0;
+    }
+
+    char *line = NULL;
+    size_t line_cap = 0;
+    int capacity = 0;
+    int line_number = 0;
+    uint64_t last_offset_us = 0;
+    ssize_t length;
+
+    while ((length = getline(&line, &line_cap, file)) >= 0) {
+        line_number++;
+        const char *end = line + length;
+        const char *p = line;
+        while (p < end && isspace((unsigned char)*p)) p++;
+        if (p == end) continue;
+
+        const char *body;
+        const char *body_end;
+        if (length > REPLAY_MAX_LINE || !find_json_member(p, end, "body", &body, &body_end) || *body != '{') {
+            fprintf(stderr, "Error: %s:%d: expected an object with a \"body\" object\n", path, line_number);
+            free(line);
+            fclose(file);
+            return 0;
+        }
+
+        // Requests without offset_ms go out together with the previous one
+        const char *offset;
+        const char *offset_end;
+        if (find_json_member(p, end, "offset_ms", &offset, &offset_end)) {
+            double offset_ms = strtod(offset, NULL);
+            last_offset_us = offset_ms > 0 ? (uint64_t)(offset_ms * 1000.0) : 0;
+        }
+
+        if (session->entry_count == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            ReplayEntry *entries = realloc(session->entries, sizeof(ReplayEntry) * (size_t)capacity);
+            if (!entries) {
+                fprintf(stderr, "Failed to allocate memory\n");
+                free(line);
+                fclose(file);
+                return 0;
+            }
+            session->entries = entries;
+        }
+
+        ReplayEntry *entry = &session->entries[session->entry_count];
+        memset(entry, 0, sizeof(ReplayEntry));
+        entry->offset_us = last_offset_us;
+
+        // Keep the body with its model value removed, so each provider can put its own in
+        const char *model;
+        const char *model_end;
+        size_t body_len = (size_t)(body_end - body);
+        if (find_json_member(body, body_end, "model", &model, &model_end) && *model == '"') {
+            size_t model_len = (size_t)(model_end - model) - 2;
+            if (model_len >= MAX_MODEL_NAME) model_len = MAX_MODEL_NAME - 1;
+            memcpy(entry->model, model + 1, model_len);
+            entry->model_start = (size_t)(model - body);
+            entry->has_model = 1;
+            body_len -= (size_t)(model_end - model);
+        } else {
+            // No model in the body: insert one as the first member
+            entry->model_start = 0;
+        }
+
+        entry->body = malloc(body_len + 1);
+        if (!entry->body) {
+            fprintf(stderr, "Failed to allocate memory\n");
+            free(line);
+            fclose(file);
+            return 0;
+        }
+        if (entry->has_model) {
+            memcpy(entry->body, body, entry->model_start);
+            memcpy(entry->body + entry->model_start, model_end, (size_t)(body_end - model_end));
+        } else {
+            memcpy(entry->body, body, body_len);
+        }
+        entry->body[body_len] = '\0';
+        session->entry_count++;
+    }
+
+    free(line);
+    fclose(file);
+
+    if (session->entry_count == 0) {
+        fprintf(stderr, "Error: Replay log '%s' contains no requests\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+static int append_output(ReplayRequest *request, const char *format, ...) {
+    for (;;) {
+        va_list args;
+        size_t available = request->out_cap - request->out_len;
+
+        va_start(args, format);
+        int written = vsnprintf(request->out + request->out_len, available, format, args);
+        va_end(args);
+
+        if (written < 0) return 0;
+        if ((size_t)written < available) {
+            request->out_len += (size_t)written;
+            return 1;
+        }
+
+        size_t capacity = request->out_cap ? request->out_cap * 2 : 4096;
+        while (capacity - request->out_len <= (size_t)written) capacity *= 2;
+        char *out = realloc(request->out, capacity);
+        if (!out) return 0;
+        request->out = out;
+        request->out_cap = capacity;
+    }
+}
+
+static int find_group(ReplaySession *session, int target, const char *model) {
+    for (int i = 0; i < session->group_count; i++) {
+        if (session->groups[i].target == target && strcmp(session->groups[i].model, model) == 0) {
+            return i;
+        }
+    }
+
+    if (session->group_count == session->group_capacity) {
+        int capacity = session->group_capacity ? session->group_capacity * 2 : 16;
+        ReplayGroup *groups = realloc(session->groups, sizeof(ReplayGroup) * (size_t)capacity);
+        if (!groups) return -1;
+        session->groups = groups;
+        session->group_capacity = capacity;
+    }
+
+    ReplayGroup *group = &session->groups[session->group_count];
+    memset(group, 0, sizeof(ReplayGroup));
+    group->target = target;
+    strncpy(group->model, model, MAX_MODEL_NAME - 1);
+    return session->group_count++;
+}
+
+static void record_sample(ReplayGroup *group, uint32_t ttft_us, uint32_t e2e_us) {
+    if (group->completed == group->capacity) {
+        int capacity = group->capacity ? group->capacity * 2 : 256;
+        uint32_t *ttft = realloc(group->ttft_us, sizeof(uint32_t) * (size_t)capacity);
+        if (!ttft) return;
+        group->ttft_us = ttft;
+        uint32_t *e2e = realloc(group->e2e_us, sizeof(uint32_t) * (size_t)capacity);
+        if (!e2e) return;
+        group->e2e_us = e2e;
+        group->capacity = capacity;
+    }
+    group->ttft_us[group->completed] = ttft_us;
+    group->e2e_us[group->completed] = e2e_us;
+    group->completed++;
+}
+
+static uint32_t clamp_us(uint64_t value) {
+    return value > UINT32_MAX ? UINT32_MAX : (uint32_t)value;
+}
+
+// Requests are recycled, never freed, so pending timeout timers can always check their tag
+static void finish_request(ReplaySession *session, ReplayRequest *request, int success, int timed_out) {
+    ReplayGroup *group = &session->groups[request->group];
+    uint64_t now = monotonic_time_us();
+
+    if (success) {
+        uint64_t first_token = request->first_token_us ? request->first_token_us : now;
+        record_sample(group, clamp_us(first_token - request->start_us), clamp_us(now - request->start_us));
+
+        // Output tokens: the last usage figure (message_delta for streams)
+        const char *usage = NULL;
+        const char *search = request->in + request->header_length;
+        const char *found;
+        while ((found = strstr(search, "\"output_tokens\":")) != NULL) {
+            usage = found;
+            search = found + 1;
+        }
+        if (usage) group->output_tokens += strtoull(usage + strlen("\"output_tokens\":"), NULL, 10);
+    } else {
+        group->errors++;
+        if (timed_out) group->timeouts++;
+    }
+    if (now > group->last_end_us) group->last_end_us = now;
+
+    if (request->fd >= 0) {
+        event_loop_remove(session->loop, request->fd);
+        close(request->fd);
+    }
+    request->fd = -1;
+    request->generation++;
+    request->next_free = session->free_requests;
+    session->free_requests = request;
+    session->in_flight--;
+}
+
+// Check the buffered response; returns 1 once it is complete
+static int response_complete(ReplayRequest *request) {
+    if (request->header_length == 0) {
+        request->header_length = http_header_length(request->in, request->in_len);
+        if (request->header_length == 0) return 0;
+
+        char value[64];
+        sscanf(request->in, "HTTP/%*s %d", &request->status);
+        request->content_length = -1;
+        if (http_header_value(request->in, request->header_length, "Content-Length", value, sizeof(value))) {
+            request->content_length = strtol(value, NULL, 10);
+        }
+        request->chunked = http_header_value(request->in, request->header_length, "Transfer-Encoding",
+                                             value, sizeof(value)) && strcasecmp(value, "chunked") == 0;
+
+        // Non-streamed responses arrive as a whole: count the headers as the first token
+        if (!(http_header_value(request->in, request->header_length, "Content-Type", value, sizeof(value)) &&
+              strncasecmp(value, "text/event-stream", 17) == 0)) {
+            request->first_token_us = monotonic_time_us();
+        }
+        request->scanned = request->header_length;
+    }
+
+    if (!request->first_token_us) {
+        size_t from = request->scanned > 32 ? request->scanned - 32 : 0;
+        if (strstr(request->in + from, "content_block_delta")) {
+            request->first_token_us = monotonic_time_us();
+        }
+        request->scanned = request->in_len;
+    }
+
+    size_t body_length = request->in_len - request->header_length;
+    if (request->content_length >= 0) {
+        return body_length >= (size_t)request->content_length;
+    }
+    if (request->chunked) {
+        return body_length >= 5 && memcmp(request->in + request->in_len - 5, "0\r\n\r\n", 5) == 0;
+    }
+    return 0;  // Delimited by connection close
+}
+
+static void handle_readable(ReplaySession *session, ReplayRequest *request) {
+    for (;;) {
+        if (request->in_cap - request->in_len < REPLAY_READ_CHUNK + 1) {
+            size_t capacity = request->in_cap ? request->in_cap * 2 : REPLAY_READ_CHUNK * 2;
+            char *in = realloc(request->in, capacity);
+            if (!in) {
+                finish_request(session, request, 0, 0);
+                return;
+            }
+            request->in = in;
+            request->in_cap = capacity;
+        }
+
+        ssize_t received = recv(request->fd, request->in + request->in_len,
+                                request->in_cap - request->in_len - 1, 0);
+        if (received > 0) {
+            request->in_len += (size_t)received;
+            request->in[request->in_len] = '\0';
+            continue;
+        }
+        if (received < 0 && errno == EINTR) continue;
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+
+        // Peer closed: complete if the headers arrived and nothing was cut short
+        int complete = response_complete(request) ||
+                       (request->header_length > 0 && request->content_length < 0 && !request->chunked);
+        finish_request(session, request, complete && request->status / 100 == 2, 0);
+        return;
+    }
+
+    if (response_complete(request)) {
+        finish_request(session, request, request->status / 100 == 2, 0);
+    }
+}
+
+static void handle_writable(ReplaySession *session, ReplayRequest *request) {
+    if (request->state == REPLAY_CONNECTING) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(request->fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0) {
+            finish_request(session, request, 0, 0);
+            return;
+        }
+        request->state = REPLAY_SENDING;
+    }
+
+    while (request->out_sent < request->out_len) {
+        ssize_t sent = send(request->fd, request->out + request->out_sent,
+                            request->out_len - request->out_sent, 0);
+        if (sent > 0) {
+            request->out_sent += (size_t)sent;
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        finish_request(session, request, 0, 0);
+        return;
+    }
+
+    request->state = REPLAY_RECEIVING;
+    event_loop_modify(session->loop, request->fd, LOOP_READ, request);
+}
+
+// Start one request of an entry against one target
+static void start_request(ReplaySession *session, const ReplayEntry *entry, int target_index) {
+    ReplayTarget *target = &session->targets[target_index];
+    const ProviderConfig *provider = target->provider;
+
+    // The provider's default model unless the recorded one should be kept
+    const char *model = entry->has_model ? entry->model : NULL;
+    if (!session->keep_model && provider->model_count > 0) {
+        model = provider->models[0];
+    }
+
+    int group = find_group(session, target_index, model && model[0] ? model : "-");
+    if (group < 0) return;
+
+    ReplayRequest *request = session->free_requests;
+    if (request) {
+        session->free_requests = request->next_free;
+    } else {
+        request = calloc(1, sizeof(ReplayRequest));
+        if (!request) {
+            session->groups[group].errors++;
+            return;
+        }
+        request->handle.kind = REPLAY_REQUEST;
+    }
+    request->generation++;
+    request->state = REPLAY_CONNECTING;
+    request->group = group;
+    request->out_len = 0;
+    request->out_sent = 0;
+    request->in_len = 0;
+    request->header_length = 0;
+    request->status = 0;
+    request->first_token_us = 0;
+    request->start_us = monotonic_time_us();
+    request->next_free = NULL;
+    session->in_flight++;
+
+    ReplayGroup *stats = &session->groups[group];
+    if (!stats->first_start_us) stats->first_start_us = request->start_us;
+
+    const char *key = provider->api_key;
+    if (provider->api_key_count > 0) {
+        key = provider->api_keys[select_api_key(provider)];
+    }
+
+    append_output(request, "POST %s/v1/messages HTTP/1.1\r\nHost: %s:%d\r\nContent-Type: application/json\r\n"
+                  "x-api-key: %s\r\nAuthorization: Bearer %s\r\nanthropic-version: 2023-06-01\r\n",
+                  target->path, target->host, target->port, key, key);
+
+    // Rebuild the body around the chosen model: in its old place, or as the first member
+    if (!model) {
+        append_output(request, "Content-Length: %zu\r\nConnection: close\r\n\r\n%s",
+                      strlen(entry->body), entry->body);
+    } else if (entry->has_model) {
+        append_output(request, "Content-Length: %zu\r\nConnection: close\r\n\r\n%.*s\"%s\"%s",
+                      strlen(entry->body) + strlen(model) + 2, (int)entry->model_start, entry->body,
+                      model, entry->body + entry->model_start);
+    } else {
+        const char *rest = entry->body + 1;
+        while (*rest == ' ' || *rest == '\t' || *rest == '\r' || *rest == '\n') rest++;
+        const char *separator = *rest == '}' ? "" : ",";
+        append_output(request, "Content-Length: %zu\r\nConnection: close\r\n\r\n{\"model\":\"%s\"%s%s",
+                      strlen(entry->body) + strlen(model) + strlen("\"model\":\"\"") + strlen(separator),
+                      model, separator, entry->body + 1);
+    }
+
+    request->fd = connect_tcp(target->host, target->port);
+    if (request->fd < 0 || request->fd >= session->max_fds ||
+        !event_loop_add(session->loop, request->fd, LOOP_WRITE, request)) {
+        finish_request(session, request, 0, 0);
+        return;
+    }
+
+    event_loop_add_timer(session->loop, request->start_us + (uint64_t)session->timeout_ms * 1000u,
+                         request, request->generation);
+}
+
+static uint64_t entry_due_us(const ReplaySession *session, int index) {
+    if (session->rate > 0) {
+        return session->started_us + (uint64_t)((double)index * 1e6 / session->rate);
+    }
+    return session->started_us + (uint64_t)((double)session->entries[index].offset_us / session->speed);
+}
+
+// Send every entry that is due, then sleep until the next one
+static void dispatch_due(ReplaySession *session) {
+    uint64_t now = monotonic_time_us();
+
+    while (session->next_entry < session->entry_count && entry_due_us(session, session->next_entry) <= now) {
+        const ReplayEntry *entry = &session->entries[session->next_entry++];
+        for (int t = 0; t < session->target_count; t++) {
+            start_request(session, entry, t);
+        }
+    }
+
+    if (session->next_entry < session->entry_count) {
+        event_loop_add_timer(session->loop, entry_due_us(session, session->next_entry), session, 0);
+    }
+}
+
+static void print_report(ReplaySession *session, double elapsed) {
+    printf("Replayed %d of %d requests against %d provider(s) in %.1fs (%s)\n\n",
+           session->next_entry, session->entry_count, session->target_count, elapsed,
+           session->rate > 0 ? "fixed rate" : "recorded timing");
+
+    printf("%-16s %-24s %6s %6s %7s %8s  %-23s  %-23s\n", "", "", "", "", "", "",
+           "TTFT ms", "End-to-end ms");
+    printf("%-16s %-24s %6s %6s %7s %8s  %7s %7s %7s  %7s %7s %7s\n", "Provider", "Model", "OK",
+           "Errors", "Req/s", "Tok/s", "p50", "p90", "p99", "p50", "p90", "p99");
+
+    for (int i = 0; i < session->group_count; i++) {
+        ReplayGroup *group = &session->groups[i];
+        double span = group->last_end_us > group->first_start_us ?
+                      (double)(group->last_end_us - group->first_start_us) / 1e6 : 0;
+
+        sort_u32(group->ttft_us, group->completed);
+        sort_u32(group->e2e_us, group->completed);
+        printf("%-16s %-24s %6d %6d %7.2f %8.1f  %7.1f %7.1f %7.1f  %7.1f %7.1f %7.1f\n",
+               session->targets[group->target].provider->name, group->model, group->completed, group->errors,
+               span > 0 ? group->completed / span : 0, span > 0 ? group->output_tokens / span : 0,
+               percentile_u32(group->ttft_us, group->completed, 50) / 1000.0,
+               percentile_u32(group->ttft_us, group->completed, 90) / 1000.0,
+               percentile_u32(group->ttft_us, group->completed, 99) / 1000.0,
+               percentile_u32(group->e2e_us, group->completed, 50) / 1000.0,
+               percentile_u32(group->e2e_us, group->completed, 90) / 1000.0,
+               percentile_u32(group->e2e_us, group->completed, 99) / 1000.0);
+        if (group->timeouts > 0) {
+            printf("%-16s %-24s %d of the errors were timeouts\n", "", "", group->timeouts);
+        }
+    }
+}
+
+static int parse_replay_options(const CliOptions *options, ReplaySession *session,
+                                char providers[][MAX_PROVIDER_NAME], int *provider_count, const char **log_path) {
+    int opt;
+    long number;
+
+    static struct option long_options[] = {
+        {"provider",   required_argument, 0, 'p'},
+        {"rate",       required_argument, 0, 'r'},
+        {"speed",      required_argument, 0, 's'},
+        {"timeout-ms", required_argument, 0, 't'},
+        {"keep-model", no_argument,       0, 'k'},
+        {0, 0, 0, 0}
+    };
+
+    reset_option_parser();
+    while ((opt = getopt_long(options->command_argc, options->command_argv, "p:r:s:t:k",
+                              long_options, NULL)) != -1) {
+        int valid = 1;
+        switch (opt) {
+            case 'p':
+                if (!add_provider_argument(providers, provider_count, optarg)) return 0;
+                break;
+            case 'r':
+                valid = parse_double_argument(optarg, 0, REPLAY_MAX_RATE, &session->rate);
+                break;
+            case 's':
+                valid = parse_double_argument(optarg, 0, REPLAY_MAX_RATE, &session->speed) && session->speed > 0;
+                break;
+            case 't':
+                valid = parse_long_argument(optarg, 1, MAX_OPTION_MS, &number);
+                session->timeout_ms = (int)number;
+                break;
+            case 'k':
+                session->keep_model = 1;
+                break;
+            default:
+                return 0;
+        }
+        if (!valid) {
+            fprintf(stderr, "Error: Invalid replay option value '%s'\n", optarg);
+            return 0;
+        }
+    }
+
+    if (optind != options->command_argc - 1) {
+        return 0;
+    }
+    *log_path = options->command_argv[optind];
+    return 1;
+}
+
+// Replay a recorded request log against the selected providers and report latencies
+int run_replay_command(const CliOptions *options) {
+    static ReplaySession session;
+    static Config config;
+    char providers[MAX_PROVIDERS][MAX_PROVIDER_NAME];
+    int provider_count = 0;
+    const char *log_path = NULL;
+
+    session.handle.kind = REPLAY_DISPATCHER;
+    session.speed = 1.0;
+    session.timeout_ms = REPLAY_DEFAULT_TIMEOUT_MS;
+    if (strlen(options->provider) > 0) {
+        strcpy(providers[provider_count++], options->provider);
+    }
+
+    if (!parse_replay_options(options, &session, providers, &provider_count, &log_path)) {
+        fprintf(stderr, "Usage: router-switch replay [-p <provider>]... [--rate <req/s>] [--speed <factor>]\n"
+                        "         [--timeout-ms <n>] [--keep-model] <log.jsonl>\n");
+        return 1;
+    }
+
+    if (!load_config(resolve_config_path(options), &config)) {
+        return 1;
+    }
+
+    // Default to every configured provider
+    if (provider_count == 0) {
+        for (int i = 0; i < config.provider_count; i++) {
+            strcpy(providers[provider_count++], config.providers[i].name);
+        }
+    }
+
+    for (int i = 0; i < provider_count; i++) {
+        if (!validate_provider_and_model(&config, providers[i], NULL)) {
+            return 1;
+        }
+
+        ReplayTarget *target = &session.targets[session.target_count++];
+        target->provider = find_provider(&config, providers[i]);
+        if (!parse_http_url(target->provider->base_url, target->host, sizeof(target->host), &target->port,
+                            target->path, sizeof(target->path))) {
+            fprintf(stderr, "Error: Provider '%s' base_url '%s' is not a plain http:// URL "
+                    "(replay has no TLS support, use a local TLS-terminating proxy)\n",
+                    target->provider->name, target->provider->base_url);
+            return 1;
+        }
+    }
+
+    if (!load_replay_log(log_path, &session)) {
+        return 1;
+    }
+
+    session.max_fds = raise_fd_limit();
+    session.loop = event_loop_create(session.max_fds);
+    if (!session.loop) {
+        fprintf(stderr, "Error: Failed to create event loop\n");
+        return 1;
+    }
+
+    struct sigaction action = {0};
+    action.sa_handler = handle_stop_signal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    fprintf(stderr, "Replaying %d requests from %s against %d provider(s)...\n",
+            session.entry_count, log_path, session.target_count);
+
+    LoopEvent events[REPLAY_MAX_EVENTS];
+    session.started_us = monotonic_time_us();
+    dispatch_due(&session);
+
+    while (!replay_stop_requested && (session.in_flight > 0 || session.next_entry < session.entry_count)) {
+        int count = event_loop_wait(session.loop, events, REPLAY_MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "Error: Event loop failed: %s\n", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (((LoopHandle *)events[i].data)->kind == REPLAY_DISPATCHER) {
+                dispatch_due(&session);
+                continue;
+            }
+
+            ReplayRequest *request = events[i].data;
+            if (events[i].events & LOOP_TIMER) {
+                if (request->generation == events[i].tag && request->fd >= 0) {
+                    finish_request(&session, request, 0, 1);
+                }
+                continue;
+            }
+            if (request->fd < 0) continue;
+            if (events[i].events & (LOOP_WRITE | LOOP_ERROR)) {
+                if (request->state != REPLAY_RECEIVING) {
+                    handle_writable(&session, request);
+                    continue;
+                }
+            }
+            if (events[i].events & (LOOP_READ | LOOP_ERROR)) {
+                handle_readable(&session, request);
+            }
+        }
+    }
+
+    print_report(&session, (double)(monotonic_time_us() - session.started_us) / 1e6);
+    event_loop_destroy(session.loop);
+    return 0;
+}
@@ -1,14 +1,24 @@
 #ifndef ROUTER_SWITCH_H
 #define ROUTER_SWITCH_H
 
+// Expose POSIX/XSI interfaces (strdup, mmap, clock_gettime, realpath) under -std=c99
+#ifndef _XOPEN_SOURCE
+#define _XOPEN_SOURCE 700
+#endif
+#ifdef __APPLE__
+#define _DARWIN_C_SOURCE
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <getopt.h>
+#include <stdint.h>
 
 // Maximum string lengths
 #define MAX_CONFIG_PATH 1024
+#define DEFAULT_CONFIG_PATH "config.json"
 #define MAX_PROVIDER_NAME 64
 #define MAX_MODEL_NAME 64
 #define MAX_ENV_VAR_NAME 128
@@ -16,6 +26,26 @@
 #define MAX_COMMAND_LENGTH 2048
 #define MAX_PROVIDERS 10
 #define MAX_MODELS_PER_PROVIDER 20
+#define MAX_API_KEYS 8
+#define MAX_KEY_POOLS 64
+#define MAX_COMMAND_NAME 32
+#define STATS_RING_SLOTS 4096
+#define MAX_HOST_NAME 256
+#define MAX_URL_PATH 512
+#define MAX_OPTION_MS (24 * 3600 * 1000)   // upper bound for millisecond options
+
+// Event loop interest and result flags
+#define LOOP_READ 1u
+#define LOOP_WRITE 2u
+#define LOOP_ERROR 4u
+#define LOOP_TIMER 8u
+
+// API key selection policy for providers with an api_keys pool
+typedef enum {
+    KEY_POLICY_ROUND_ROBIN = 0,
+    KEY_POLICY_LEAST_RECENTLY_USED,
+    KEY_POLICY_WEIGHTED
+} KeyPolicy;
 
 // Provider configuration structure
 typedef struct {
@@ -23,6 +53,10 @@ typedef struct {
     char description[256];
     char base_url[512];
     char api_key[512];
+    char api_keys[MAX_API_KEYS][512];
+    int key_weights[MAX_API_KEYS];
+    int api_key_count;
+    KeyPolicy key_policy;
     char models[MAX_MODELS_PER_PROVIDER][MAX_MODEL_NAME];
     int model_count;
     char env_names[MAX_PROVIDERS][MAX_ENV_VAR_NAME];
@@ -36,6 +70,54 @@ typedef struct {
     int provider_count;
 } Config;
 
+// Provider tables compiled into the binary by `make embed` (see tools/embed-config.c).
+// Export strings are pre-escaped shell lines, ready to be written as-is.
+typedef struct {
+    const char *name;
+    const char *description;
+    const char *base_url;
+    const char *api_key;
+    const char *const *api_keys;
+    const int *key_weights;
+    int api_key_count;
+    KeyPolicy key_policy;
+    const char *const *models;
+    int model_count;
+    const char *const *env_names;
+    const char *const *env_values;
+    int env_count;
+    const char *unset_script;             // clear_provider_environment output
+    const char *base_url_export;          // export ANTHROPIC_BASE_URL=...
+    const char *api_key_export;           // export ANTHROPIC_AUTH_TOKEN=... (single key)
+    const char *const *api_key_exports;   // one export line per pooled key
+    const char *const *model_exports;     // export ANTHROPIC_MODEL=... per model
+    const char *env_exports;              // custom env and provider tracking exports
+} EmbeddedProvider;
+
+typedef struct {
+    const EmbeddedProvider *providers;
+    int provider_count;
+    const int16_t *index;                 // perfect hash slots: provider index or -1
+    uint32_t index_size;                  // power of two
+    uint32_t hash_seed;
+    const char *source_path;
+} EmbeddedConfig;
+
+// Event loop shared by the network commands (opaque, see event_loop.c)
+typedef struct EventLoop EventLoop;
+
+typedef struct {
+    uint32_t events;             // LOOP_* flags
+    void *data;                  // pointer registered with the fd or timer
+    uint64_t tag;                // timer tag, 0 for I/O events
+} LoopEvent;
+
+// First member of every object registered with the loop, so a command can
+// dispatch on LoopEvent.data without knowing the object type up front
+typedef struct {
+    int kind;                    // command-specific object kind
+} LoopHandle;
+
 // Command line options structure
 typedef struct {
     char provider[MAX_PROVIDER_NAME];
@@ -45,14 +127,94 @@ typedef struct {
     int version;
     int verbose;
     int install;
+    int global;
+    int shared;
+    char command[MAX_COMMAND_NAME];
+    int command_argc;
+    char **command_argv;
 } CliOptions;
 
+// Shared selection state of one provider's key pool
+typedef struct {
+    uint32_t state;                         // 0 empty, 1 being claimed, 2 ready
+    uint32_t reserved;
+    char provider[MAX_PROVIDER_NAME];
+    uint64_t counter;                       // round-robin / weighted ticket
+    uint64_t last_used[MAX_API_KEYS];       // wall clock microseconds
+    uint64_t cooldown_until[MAX_API_KEYS];  // wall clock seconds
+} KeyPoolSlot;
+
+// Per-user key pool state shared by concurrently launching processes (mmap'd file)
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    KeyPoolSlot pools[MAX_KEY_POOLS];
+} KeyPoolState;
+
+// Provider selection broadcast to every shell of the user (mmap'd file).
+// The file starts with the generation as fixed-width decimal text so the
+// prompt hook can compare it with the `read` builtin alone.
+typedef struct {
+    char generation_text[24];    // "%020llu\n", NUL padded
+    uint32_t magic;
+    uint32_t version;
+    uint64_t generation;
+    uint64_t sequence;           // seqlock: odd while a writer is publishing
+    char provider[MAX_PROVIDER_NAME];
+    char model[MAX_MODEL_NAME];
+    char config_path[MAX_CONFIG_PATH];
+} SwitchState;
+
+// One buffer of the published config segment
+typedef struct {
+    uint64_t sequence;           // seqlock: odd while the slot is being written
+    uint64_t device;             // stat of the source file the config was parsed from
+    uint64_t inode;
+    uint64_t size;
+    int64_t mtime_ns;
+    int64_t ctime_ns;
+    Config config;               // flat, pointer-free: valid at any mapping address
+} SharedConfigSlot;
+
+// Parsed config published in shared memory (/dev/shm) for concurrent readers.
+// Writers fill the inactive slot and then flip the generation, so readers of
+// the active slot never wait.
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t reserved[2];        // publishers serialize with flock on the segment fd
+    uint64_t generation;         // active slot is generation & 1; 0 = nothing published
+    SharedConfigSlot slots[2];
+} SharedConfigSegment;
+
+// Switch event recorded in the statistics ring buffer
+typedef struct {
+    uint64_t sequence;           // ticket + 1 once published, 0 while empty or being written
+    int64_t timestamp;           // wall clock seconds since epoch
+    uint32_t duration_us;        // exec-to-output time of the switch
+    uint32_t reserved;
+    char provider[MAX_PROVIDER_NAME];
+    char model[MAX_MODEL_NAME];
+} StatsEvent;
+
+// Shared, per-user statistics ring buffer (mmap'd file)
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;
+    uint32_t reserved;
+    uint64_t head;               // next ticket, reserved with an atomic fetch-add
+    StatsEvent slots[STATS_RING_SLOTS];
+} StatsRing;
+
 // Function declarations
 
 // main.c
 int main(int argc, char *argv[]);
 
 // config.c
+const char* resolve_config_path(const CliOptions *options);
+uint32_t hash_provider_name(const char *name, uint32_t seed);
 int load_config(const char *config_path, Config *config);
 ProviderConfig* find_provider(const Config *config, const char *provider_name);
 int validate_provider_and_model(const Config *config, const char *provider_name, const char *model_name);
@@ -61,18 +223,87 @@ int validate_provider_and_model(const Config *config, const char *provider_name,
 void parse_command_line_args(int argc, char *argv[], CliOptions *options);
 void display_help(void);
 void display_version(void);
+void reset_option_parser(void);
+int parse_long_argument(const char *text, long min, long max, long *value);
+int parse_double_argument(const char *text, double min, double max, double *value);
+int add_provider_argument(char providers[][MAX_PROVIDER_NAME], int *provider_count, const char *name);
 
 // env_commands.c
 // Environment management functions
+char* shell_escape(const char *value);
 int clear_provider_environment(const Config *config, const char *provider_name);
 int apply_provider_environment(const Config *config, const char *provider_name, const char *model_name);
+int switch_provider_environment(const Config *config, const char *provider_name, const char *model_name, int verbose);
 void print_shell_wrapper(const Config *config);
 char* get_current_provider(void);
 
+// state.c
+int resolve_state_path(const char *file_name, char *path, size_t path_size);
+void* map_state_file(const char *file_name, size_t size);
+void unmap_state_file(void *addr, size_t size);
+int lock_state_file(const char *file_name);
+uint64_t monotonic_time_us(void);
+
+// stats.c
+void record_switch_event(const char *provider_name, const char *model_name, uint64_t start_us);
+int run_stats_command(const CliOptions *options);
+void sort_u32(uint32_t *values, int count);
+uint32_t percentile_u32(const uint32_t *sorted, int count, double pct);
+
+// key_pool.c
+int select_key_index(const char *provider_name, int count, KeyPolicy policy, const int *weights);
+int select_api_key(const ProviderConfig *provider);
+int run_cooldown_command(const CliOptions *options);
+
+// embedded.c (builds with ROUTER_SWITCH_EMBEDDED only)
+extern const EmbeddedConfig embedded_config;
+const EmbeddedProvider* find_embedded_provider(const char *provider_name);
+void load_embedded_config(Config *config);
+int embedded_switch(const CliOptions *options, uint64_t start_us);
+
+// event_loop.c
+EventLoop* event_loop_create(int max_fds);
+void event_loop_destroy(EventLoop *loop);
+int event_loop_add(EventLoop *loop, int fd, uint32_t events, void *data);
+int event_loop_modify(EventLoop *loop, int fd, uint32_t events, void *data);
+void event_loop_remove(EventLoop *loop, int fd);
+int event_loop_add_timer(EventLoop *loop, uint64_t due_us, void *data, uint64_t tag);
+int event_loop_wait(EventLoop *loop, LoopEvent *events, int max_events, int timeout_ms);
+
+// net.c
+int set_nonblocking(int fd);
+int raise_fd_limit(void);
+int listen_tcp(const char *host, int port);
+int connect_tcp(const char *host, int port);
+int parse_http_url(const char *url, char *host, size_t host_size, int *port, char *path, size_t path_size);
+size_t http_header_length(const char *data, size_t len);
+int http_header_value(const char *head, size_t head_len, const char *name, char *value, size_t value_size);
+
+// broadcast.c
+int publish_global_switch(const CliOptions *options);
+int run_sync_command(const CliOptions *options, uint64_t start_us);
+void print_sync_hook(void);
+
+// mock_server.c
+int run_mock_server_command(const CliOptions *options);
+
+// shared_config.c
+int load_shared_config(const char *config_path, Config *config);
+int run_publish_command(const CliOptions *options);
+
+// replay.c
+int run_replay_command(const CliOptions *options);
+
+// forward.c
+int run_forward_command(const CliOptions *options);
+
 // json_parser.c
 int parse_config_file(const char *filename, Config *config);
+int parse_config_provider(const char *json, const char *provider_name, ProviderConfig *provider);
 char* extract_json_string(const char *json, const char *key);
+int extract_json_bool(const char *json, const char *key, int default_value);
 int extract_json_string_array(const char *json, const char *key, char values[][MAX_MODEL_NAME], int max_values);
 int extract_json_object(const char *json, const char *key, char keys[][MAX_ENV_VAR_NAME], char values[][MAX_ENV_VAR_VALUE], int max_pairs);
+int find_json_member(const char *object, const char *end, const char *key, const char **value, const char **value_end);
 
 #endif // ROUTER_SWITCH_H
\ No newline at end of file
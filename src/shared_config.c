@@ -0,0 +1,239 @@
+#include "router-switch.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Parsed config published as a shared memory segment, one per user and
+// source file. Readers attach it read-only with a single mmap and copy the
+// active slot under its sequence counter; a stale or missing segment falls
+// back to parsing the file, which then republishes it.
+
+#define SHARED_CONFIG_MAGIC 0x43535352u // "RSSC"
+#define SHARED_CONFIG_VERSION 1
+#define MAX_SEQLOCK_SPINS 1000000
+
+// Short, per-user name derived from the file identity (macOS allows 31 characters)
+static void segment_name(const struct stat *st, char *name, size_t size) {
+    char identity[64];
+    snprintf(identity, sizeof(identity), "%llx:%llx",
+             (unsigned long long)st->st_dev, (unsigned long long)st->st_ino);
+    snprintf(name, size, "/rsw-%x-%08x", (unsigned)getuid(), hash_provider_name(identity, 0));
+}
+
+static void file_stamp(const struct stat *st, SharedConfigSlot *stamp) {
+    stamp->device = (uint64_t)st->st_dev;
+    stamp->inode = (uint64_t)st->st_ino;
+    stamp->size = (uint64_t)st->st_size;
+#ifdef __APPLE__
+    stamp->mtime_ns = (int64_t)st->st_mtimespec.tv_sec * 1000000000 + st->st_mtimespec.tv_nsec;
+    stamp->ctime_ns = (int64_t)st->st_ctimespec.tv_sec * 1000000000 + st->st_ctimespec.tv_nsec;
+#else
+    stamp->mtime_ns = (int64_t)st->st_mtim.tv_sec * 1000000000 + st->st_mtim.tv_nsec;
+    stamp->ctime_ns = (int64_t)st->st_ctim.tv_sec * 1000000000 + st->st_ctim.tv_nsec;
+#endif
+}
+
+static int same_stamp(const SharedConfigSlot *a, const SharedConfigSlot *b) {
+    return a->device == b->device && a->inode == b->inode && a->size == b->size &&
+           a->mtime_ns == b->mtime_ns && a->ctime_ns == b->ctime_ns;
+}
+
+// Map the segment; a writable attach hands back its fd in lock_fd for flock
+static SharedConfigSegment* attach_segment(const char *name, int writable, int *lock_fd) {
+    int fd = shm_open(name, writable ? O_RDWR | O_CREAT : O_RDONLY, 0600);
+    if (fd < 0) return NULL;
+
+    // /dev/shm is world-writable: only trust a segment this user created privately
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NULL;
+    }
+    if (st.st_uid != geteuid() || (st.st_mode & 077) != 0) {
+        close(fd);
+        errno = EACCES;
+        return NULL;
+    }
+    if ((size_t)st.st_size < sizeof(SharedConfigSegment) &&
+        (!writable || ftruncate(fd, (off_t)sizeof(SharedConfigSegment)) != 0)) {
+        close(fd);
+        return NULL;
+    }
+
+    void *addr = mmap(NULL, sizeof(SharedConfigSegment), writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                      MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+
+    SharedConfigSegment *segment = addr;
+    if (writable && __atomic_load_n(&segment->magic, __ATOMIC_ACQUIRE) == 0) {
+        uint32_t expected = 0;
+        segment->version = SHARED_CONFIG_VERSION;
+        __atomic_compare_exchange_n(&segment->magic, &expected, SHARED_CONFIG_MAGIC, 0,
+                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+    }
+    if (__atomic_load_n(&segment->magic, __ATOMIC_ACQUIRE) != SHARED_CONFIG_MAGIC ||
+        segment->version != SHARED_CONFIG_VERSION) {
+        munmap(addr, sizeof(SharedConfigSegment));
+        close(fd);
+        return NULL;
+    }
+
+    if (writable) {
+        *lock_fd = fd;
+    } else {
+        close(fd);
+    }
+    return segment;
+}
+
+// Copy the active slot if it was parsed from the file described by stamp
+static int read_segment(const SharedConfigSegment *segment, const SharedConfigSlot *stamp, Config *config) {
+    for (int attempt = 0; attempt < MAX_SEQLOCK_SPINS; attempt++) {
+        uint64_t generation = __atomic_load_n(&segment->generation, __ATOMIC_ACQUIRE);
+        if (generation == 0) return 0;
+
+        const SharedConfigSlot *slot = &segment->slots[generation & 1];
+        uint64_t before = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        if (before & 1) continue;
+
+        // Only the populated providers; a torn count is caught by the sequence check
+        int matches = same_stamp(slot, stamp);
+        int count = slot->config.provider_count;
+        if (count < 0 || count > MAX_PROVIDERS) count = 0;
+        if (matches) {
+            memcpy(config->providers, slot->config.providers, sizeof(ProviderConfig) * (size_t)count);
+            config->provider_count = count;
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) == before) {
+            return matches;
+        }
+    }
+    return 0;
+}
+
+// Fill the inactive slot, then make it the active one. The caller holds the
+// segment's flock, so a slot left odd by a writer that died is safe to reuse.
+static void write_segment(SharedConfigSegment *segment, const SharedConfigSlot *stamp, const Config *config) {
+    uint64_t generation = __atomic_load_n(&segment->generation, __ATOMIC_RELAXED);
+    SharedConfigSlot *slot = &segment->slots[(generation + 1) & 1];
+    uint64_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) | 1;
+
+    __atomic_store_n(&slot->sequence, sequence, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot->device = stamp->device;
+    slot->inode = stamp->inode;
+    slot->size = stamp->size;
+    slot->mtime_ns = stamp->mtime_ns;
+    slot->ctime_ns = stamp->ctime_ns;
+    memcpy(&slot->config, config, sizeof(Config));
+
+    __atomic_store_n(&slot->sequence, sequence + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&segment->generation, generation + 1, __ATOMIC_RELEASE);
+}
+
+// Store a parsed config in the segment; returns the new generation, or 0 on
+// failure. Without wait, a segment another writer holds is left alone.
+static uint64_t publish_segment(const char *name, const SharedConfigSlot *stamp, const Config *config, int wait) {
+    int fd = -1;
+    SharedConfigSegment *segment = attach_segment(name, 1, &fd);
+    if (!segment) {
+        return 0;
+    }
+
+    uint64_t generation = 0;
+    if (flock(fd, wait ? LOCK_EX : LOCK_EX | LOCK_NB) == 0) {
+        write_segment(segment, stamp, config);
+        generation = __atomic_load_n(&segment->generation, __ATOMIC_ACQUIRE);
+    }
+    munmap(segment, sizeof(SharedConfigSegment));
+    close(fd);   // releases the lock
+    return generation;
+}
+
+// load_config through the shared segment: attach and copy when it is current,
+// otherwise parse the file and republish it for the next readers
+int load_shared_config(const char *config_path, Config *config) {
+    struct stat st;
+    char name[64];
+
+    if (config_path == NULL || stat(config_path, &st) != 0) {
+        return load_config(config_path, config);   // embedded tables, or report the missing file
+    }
+    segment_name(&st, name, sizeof(name));
+
+    // Stat before parsing, so a file edited meanwhile never looks current
+    SharedConfigSlot stamp;
+    file_stamp(&st, &stamp);
+
+    SharedConfigSegment *segment = attach_segment(name, 0, NULL);
+    if (segment) {
+        int found = read_segment(segment, &stamp, config);
+        munmap((void *)segment, sizeof(SharedConfigSegment));
+        if (found) return 1;
+    }
+
+    if (!load_config(config_path, config)) {
+        return 0;
+    }
+    // Best effort: when many stale readers start at once only one republishes,
+    // the others skip it as the parsed copy is enough for this run
+    publish_segment(name, &stamp, config, 0);
+    return 1;
+}
+
+// Publish (or with --unlink remove) the segment for the resolved config file
+int run_publish_command(const CliOptions *options) {
+    static Config config;
+    const char *config_path = resolve_config_path(options);
+    struct stat st;
+    char name[64];
+    int unlink_segment = options->command_argc == 2 && strcmp(options->command_argv[1], "--unlink") == 0;
+
+    if (options->command_argc > 2 || (options->command_argc == 2 && !unlink_segment)) {
+        fprintf(stderr, "Usage: router-switch [-c <config>] publish [--unlink]\n");
+        return 1;
+    }
+    if (config_path == NULL) {
+        fprintf(stderr, "Error: Built-in configuration needs no publishing, use --config for a file\n");
+        return 1;
+    }
+    if (stat(config_path, &st) != 0) {
+        fprintf(stderr, "Failed to open config file '%s'\n", config_path);
+        return 1;
+    }
+    segment_name(&st, name, sizeof(name));
+
+    if (unlink_segment) {
+        if (shm_unlink(name) != 0 && errno != ENOENT) {
+            fprintf(stderr, "Error: Failed to remove shared config %s: %s\n", name, strerror(errno));
+            return 1;
+        }
+        printf("Removed shared config %s for %s\n", name, config_path);
+        return 0;
+    }
+
+    SharedConfigSlot stamp;
+    file_stamp(&st, &stamp);
+    if (!load_config(config_path, &config)) {
+        return 1;
+    }
+
+    uint64_t generation = publish_segment(name, &stamp, &config, 1);
+    if (generation == 0) {
+        fprintf(stderr, "Error: Failed to create shared config %s: %s\n", name, strerror(errno));
+        return 1;
+    }
+
+    printf("Published %s as shared config %s (generation %llu, %d providers, %zu bytes)\n",
+           config_path, name, (unsigned long long)generation, config.provider_count,
+           sizeof(SharedConfigSegment));
+    return 0;
+}
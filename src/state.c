@@ -0,0 +1,112 @@
+#include "router-switch.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Create every missing directory above the file at path (mode 0700, per-user state)
+static int make_parent_directories(char *path) {
+    for (char *p = path + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(path, 0700) != 0 && errno != EEXIST) {
+            *p = '/';
+            return 0;
+        }
+        *p = '/';
+    }
+    return 1;
+}
+
+// Resolve a file inside the per-user state directory; the directory may not exist yet.
+// Lookup order: $ROUTERSWITCH_STATE_DIR, $XDG_STATE_HOME/router-switch, ~/.local/state/router-switch
+int resolve_state_path(const char *file_name, char *path, size_t path_size) {
+    char dir[MAX_CONFIG_PATH];
+    const char *override = getenv("ROUTERSWITCH_STATE_DIR");
+    const char *xdg = getenv("XDG_STATE_HOME");
+    const char *home = getenv("HOME");
+    int written;
+
+    if (override && *override) {
+        written = snprintf(dir, sizeof(dir), "%s", override);
+    } else if (xdg && *xdg) {
+        written = snprintf(dir, sizeof(dir), "%s/router-switch", xdg);
+    } else if (home && *home) {
+        written = snprintf(dir, sizeof(dir), "%s/.local/state/router-switch", home);
+    } else {
+        return 0;
+    }
+    if (written < 0 || (size_t)written >= sizeof(dir)) {
+        return 0;
+    }
+
+    written = snprintf(path, path_size, "%s/%s", dir, file_name);
+    return written > 0 && (size_t)written < path_size;
+}
+
+// Map a shared state file of a fixed size, creating and zero-extending it if needed.
+// Concurrent creators race benignly: every process extends the file to the same size.
+void* map_state_file(const char *file_name, size_t size) {
+    char path[MAX_CONFIG_PATH];
+    struct stat st;
+
+    if (!resolve_state_path(file_name, path, sizeof(path))) {
+        return NULL;
+    }
+
+    // Directories are only created on first use, so a normal switch is one open
+    int fd = open(path, O_RDWR | O_CREAT, 0600);
+    if (fd < 0 && errno == ENOENT && make_parent_directories(path)) {
+        fd = open(path, O_RDWR | O_CREAT, 0600);
+    }
+    if (fd < 0) {
+        return NULL;
+    }
+
+    if (fstat(fd, &st) != 0 || ((size_t)st.st_size < size && ftruncate(fd, (off_t)size) != 0)) {
+        close(fd);
+        return NULL;
+    }
+
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    return addr == MAP_FAILED ? NULL : addr;
+}
+
+void unmap_state_file(void *addr, size_t size) {
+    if (addr) {
+        munmap(addr, size);
+    }
+}
+
+uint64_t monotonic_time_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+// Take an exclusive flock on an existing state file, waiting for the holder;
+// returns the descriptor to close to release it, or -1. The kernel drops the
+// lock if the holder dies, unlike a flag kept in the mapping.
+int lock_state_file(const char *file_name) {
+    char path[MAX_CONFIG_PATH];
+
+    if (!resolve_state_path(file_name, path, sizeof(path))) {
+        return -1;
+    }
+
+    int fd = open(path, O_RDWR);
+    if (fd < 0) {
+        return -1;
+    }
+    while (flock(fd, LOCK_EX) != 0) {
+        if (errno != EINTR) {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
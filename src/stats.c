@@ -0,0 +1,213 @@
+#include "router-switch.h"
+#include <time.h>
+
+#define STATS_FILE "stats.ring"
+#define STATS_MAGIC 0x54535352u // "RSST"
+#define STATS_VERSION 1
+#define MAX_STATS_GROUPS 256
+
+// Per provider/model aggregate used by the stats command
+typedef struct {
+    char provider[MAX_PROVIDER_NAME];
+    char model[MAX_MODEL_NAME];
+    int count;
+    int64_t last_used;
+} StatsGroup;
+
+// Attach the ring, initializing the header on first use. Returns NULL if the
+// file is unavailable or was written by an incompatible layout.
+static StatsRing* attach_stats_ring(void) {
+    StatsRing *ring = map_state_file(STATS_FILE, sizeof(StatsRing));
+    if (!ring) return NULL;
+
+    uint32_t expected = 0;
+    if (__atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE) == 0) {
+        // Header fields are constants, so concurrent initializers write identical values
+        ring->version = STATS_VERSION;
+        ring->slot_count = STATS_RING_SLOTS;
+        __atomic_compare_exchange_n(&ring->magic, &expected, STATS_MAGIC, 0,
+                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+    }
+
+    if (__atomic_load_n(&ring->magic, __ATOMIC_ACQUIRE) != STATS_MAGIC ||
+        ring->version != STATS_VERSION || ring->slot_count != STATS_RING_SLOTS) {
+        unmap_state_file(ring, sizeof(StatsRing));
+        return NULL;
+    }
+    return ring;
+}
+
+// Record one switch event. Lock-free: a slot is reserved with an atomic
+// fetch-add on the head and published through its sequence number. Nothing is
+// synced to disk; the page cache carries the data. Failures are silent so
+// statistics can never break a switch.
+void record_switch_event(const char *provider_name, const char *model_name, uint64_t start_us) {
+    if (getenv("ROUTERSWITCH_NO_STATS")) return;
+
+    StatsRing *ring = attach_stats_ring();
+    if (!ring) return;
+
+    uint64_t ticket = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+    StatsEvent *slot = &ring->slots[ticket % STATS_RING_SLOTS];
+    uint64_t elapsed = monotonic_time_us() - start_us;
+
+    // Mark the slot as being written before touching its payload
+    __atomic_store_n(&slot->sequence, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    slot->timestamp = (int64_t)time(NULL);
+    slot->duration_us = elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+    strncpy(slot->provider, provider_name, MAX_PROVIDER_NAME - 1);
+    slot->provider[MAX_PROVIDER_NAME - 1] = '\0';
+    strncpy(slot->model, model_name ? model_name : "", MAX_MODEL_NAME - 1);
+    slot->model[MAX_MODEL_NAME - 1] = '\0';
+
+    __atomic_store_n(&slot->sequence, ticket + 1, __ATOMIC_RELEASE);
+
+    unmap_state_file(ring, sizeof(StatsRing));
+}
+
+// Copy a slot out under its sequence number; returns 0 for empty or torn slots
+static int read_stats_slot(const StatsEvent *slot, StatsEvent *out) {
+    uint64_t before = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+    if (before == 0) return 0;
+
+    memcpy(out, slot, sizeof(StatsEvent));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    if (__atomic_load_n(&slot->sequence, __ATOMIC_RELAXED) != before) return 0;
+    out->provider[MAX_PROVIDER_NAME - 1] = '\0';
+    out->model[MAX_MODEL_NAME - 1] = '\0';
+    return 1;
+}
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+void sort_u32(uint32_t *values, int count) {
+    qsort(values, (size_t)count, sizeof(uint32_t), compare_u32);
+}
+
+// Nearest-rank percentile over an ascending array
+uint32_t percentile_u32(const uint32_t *sorted, int count, double pct) {
+    if (count <= 0) return 0;
+    int rank = (int)(pct / 100.0 * count + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > count) rank = count;
+    return sorted[rank - 1];
+}
+
+static int compare_groups(const void *a, const void *b) {
+    const StatsGroup *x = a;
+    const StatsGroup *y = b;
+    if (x->count != y->count) return y->count - x->count;
+    return (y->last_used > x->last_used) - (y->last_used < x->last_used);
+}
+
+static void format_age(int64_t seconds, char *buf, size_t size) {
+    if (seconds < 0) seconds = 0;
+    if (seconds < 60) snprintf(buf, size, "%llds ago", (long long)seconds);
+    else if (seconds < 3600) snprintf(buf, size, "%lldm ago", (long long)(seconds / 60));
+    else if (seconds < 86400) snprintf(buf, size, "%lldh ago", (long long)(seconds / 3600));
+    else snprintf(buf, size, "%lldd ago", (long long)(seconds / 86400));
+}
+
+// Aggregate the ring into usage counts, recency and latency percentiles
+int run_stats_command(const CliOptions *options) {
+    (void)options;
+
+    StatsRing *ring = attach_stats_ring();
+    if (!ring) {
+        fprintf(stderr, "Error: Failed to open switch statistics\n");
+        return 1;
+    }
+
+    StatsGroup *groups = calloc(MAX_STATS_GROUPS, sizeof(StatsGroup));
+    uint32_t *durations = malloc(sizeof(uint32_t) * STATS_RING_SLOTS);
+    if (!groups || !durations) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        free(groups);
+        free(durations);
+        unmap_state_file(ring, sizeof(StatsRing));
+        return 1;
+    }
+
+    int64_t now = (int64_t)time(NULL);
+    int group_count = 0;
+    int event_count = 0;
+    int last_hour = 0, last_day = 0, last_week = 0;
+    StatsEvent latest = {0};
+
+    for (int i = 0; i < STATS_RING_SLOTS; i++) {
+        StatsEvent event;
+        if (!read_stats_slot(&ring->slots[i], &event)) continue;
+
+        durations[event_count++] = event.duration_us;
+        if (event.sequence > latest.sequence) latest = event;
+
+        int64_t age = now - event.timestamp;
+        if (age < 3600) last_hour++;
+        if (age < 86400) last_day++;
+        if (age < 7 * 86400) last_week++;
+
+        StatsGroup *group = NULL;
+        for (int g = 0; g < group_count; g++) {
+            if (strcmp(groups[g].provider, event.provider) == 0 &&
+                strcmp(groups[g].model, event.model) == 0) {
+                group = &groups[g];
+                break;
+            }
+        }
+        if (!group && group_count < MAX_STATS_GROUPS) {
+            group = &groups[group_count++];
+            strcpy(group->provider, event.provider);
+            strcpy(group->model, event.model);
+        }
+        if (group) {
+            group->count++;
+            if (event.timestamp > group->last_used) group->last_used = event.timestamp;
+        }
+    }
+
+    uint64_t total = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    unmap_state_file(ring, sizeof(StatsRing));
+
+    if (event_count == 0) {
+        printf("No switches recorded yet\n");
+        free(groups);
+        free(durations);
+        return 0;
+    }
+
+    char age[32];
+    qsort(groups, (size_t)group_count, sizeof(StatsGroup), compare_groups);
+    sort_u32(durations, event_count);
+
+    printf("Switch statistics (%d events in buffer, %llu recorded in total)\n",
+           event_count, (unsigned long long)total);
+    format_age(now - latest.timestamp, age, sizeof(age));
+    printf("Last switch: %s (%s%s%s)\n", age, latest.provider,
+           latest.model[0] ? " / " : "", latest.model);
+    printf("Switches: %d in last hour, %d in last 24h, %d in last 7 days\n\n",
+           last_hour, last_day, last_week);
+
+    printf("%-20s %-28s %8s  %s\n", "Provider", "Model", "Switches", "Last used");
+    for (int g = 0; g < group_count; g++) {
+        format_age(now - groups[g].last_used, age, sizeof(age));
+        printf("%-20s %-28s %8d  %s\n", groups[g].provider,
+               groups[g].model[0] ? groups[g].model : "-", groups[g].count, age);
+    }
+
+    printf("\nSwitch latency (us): p50 %u, p90 %u, p99 %u, max %u\n",
+           percentile_u32(durations, event_count, 50),
+           percentile_u32(durations, event_count, 90),
+           percentile_u32(durations, event_count, 99),
+           durations[event_count - 1]);
+
+    free(groups);
+    free(durations);
+    return 0;
+}
@@ -0,0 +1,86 @@
+#!/bin/bash
+
+# Benchmark suite for RouterSwitch (run via `make bench`)
+# Compares exec-to-exit latency, CPU time and peak RSS of the full and lite
+# binaries, then parsing against the shared config segment under contention
+
+set -e
+
+BINDIR=${BINDIR:-bin/release}
+BENCH_EXEC=${BENCH_EXEC:-obj/release/bench-exec}
+RUNS=${RUNS:-500}
+ROUNDS=${ROUNDS:-20}
+
+BENCH_DIR=$(mktemp -d)
+trap 'rm -rf "$BENCH_DIR"' EXIT
+export ROUTERSWITCH_STATE_DIR="$BENCH_DIR/state"
+CONFIG="$BENCH_DIR/config.json"
+
+# A config of the largest supported size (MAX_PROVIDERS providers), with the
+# selected provider in the middle of the file
+{
+    echo '{'
+    echo '  "providers": {'
+    for i in $(seq 1 10); do
+        echo "    \"provider$i\": {"
+        echo "      \"description\": \"Benchmark provider $i\","
+        echo "      \"base_url\": \"https://api.provider$i.example.com/anthropic\","
+        echo "      \"api_key\": \"sk-bench-$i-0123456789abcdef\","
+        echo "      \"models\": [\"model-$i-large\", \"model-$i-small\"],"
+        echo "      \"env\": { \"API_TIMEOUT_MS\": \"600000\", \"PROVIDER_TAG\": \"bench $i\" }"
+        if [ "$i" -lt 10 ]; then echo '    },'; else echo '    }'; fi
+    done
+    echo '  }'
+    echo '}'
+} > "$CONFIG"
+
+echo "=== Switch latency: exec to exit, $RUNS runs (us) ==="
+printf "%-24s %6s %9s %9s %9s %9s %9s %9s\n" "Binary" "Runs" "p50" "p90" "p99" "Mean" "CPU" "RSS KB"
+
+"$BENCH_EXEC" -n "$RUNS" -l "router-switch" \
+    "$BINDIR/router-switch" -c "$CONFIG" -p provider5 -m model-5-small
+"$BENCH_EXEC" -n "$RUNS" -l "router-switch-lite" \
+    "$BINDIR/router-switch-lite" -c "$CONFIG" -p provider5 -m model-5-small
+# The embedded binary has the same config compiled in and runs without -c
+"${MAKE:-make}" -s embed BUILD_TYPE="${BUILD_TYPE:-release}" CONFIG="$CONFIG" > /dev/null 2>&1
+"$BENCH_EXEC" -n "$RUNS" -l "router-switch-embedded" \
+    "$BINDIR/router-switch-embedded" -p provider5 -m model-5-small
+
+# Both binaries must print the same switch
+export ROUTERSWITCH_NO_STATS=1
+export ROUTERSWITCH_CURRENT_PROVIDER=provider3
+if ! diff <("$BINDIR/router-switch" -c "$CONFIG" -p provider5) \
+          <("$BINDIR/router-switch-lite" -c "$CONFIG" -p provider5) > /dev/null; then
+    echo "FAIL: router-switch-lite output differs from router-switch"
+    exit 1
+fi
+if ! diff <("$BINDIR/router-switch" -c "$CONFIG" -p provider5) \
+          <("$BINDIR/router-switch-embedded" -p provider5) > /dev/null; then
+    echo "FAIL: router-switch-embedded output differs from router-switch"
+    exit 1
+fi
+
+# Many cold starts at once, as in a CI fan-out: every parse reads and tokenizes
+# the whole file, a --shared start copies one slot from the published segment
+echo ""
+echo "=== Concurrent starts: parse vs --shared, $ROUNDS rounds (us) ==="
+printf "%-24s %6s %9s %9s %9s %9s %9s %9s\n" "Mode" "Runs" "p50" "p90" "p99" "Mean" "CPU" "RSS KB"
+
+"$BINDIR/router-switch" -c "$CONFIG" publish > /dev/null
+for n in 1 16 64 256; do
+    "$BENCH_EXEC" -n "$ROUNDS" -w 2 -c "$n" -l "parse x$n" \
+        "$BINDIR/router-switch" -c "$CONFIG" -p provider5 -m model-5-small
+    "$BENCH_EXEC" -n "$ROUNDS" -w 2 -c "$n" -l "shared x$n" \
+        "$BINDIR/router-switch" -c "$CONFIG" --shared -p provider5 -m model-5-small
+done
+
+if ! diff <("$BINDIR/router-switch" -c "$CONFIG" -p provider5) \
+          <("$BINDIR/router-switch" -c "$CONFIG" --shared -p provider5) > /dev/null; then
+    echo "FAIL: --shared output differs from parsing the config"
+    exit 1
+fi
+"$BINDIR/router-switch" -c "$CONFIG" publish --unlink > /dev/null
+
+echo ""
+echo "=== Binary size ==="
+ls -l "$BINDIR"/router-switch* | awk '{ printf "%-40s %10d bytes\n", $NF, $5 }'
@@ -7,17 +7,48 @@ set -e
 
 echo "Starting RouterSwitch tests..."
 
+# Binaries are built into bin/<type>; the tests run them from a scratch
+# directory holding links to them and a config.json of their own, keeping
+# stats, global switch and key pool state out of the user's own state directory
+BINDIR=${BINDIR:-bin/release}
+REPO_DIR=$PWD
+TEST_DIR=$(mktemp -d)
+export ROUTERSWITCH_STATE_DIR=$(mktemp -d)
+trap 'rm -rf "$TEST_DIR" "$ROUTERSWITCH_STATE_DIR"' EXIT
+
 # Test 1: Build the project
 echo "Test 1: Building the project..."
 make clean
-make all
+make all lite
 
-if [ ! -f "./router-switch" ]; then
+if [ ! -f "$BINDIR/router-switch" ]; then
     echo "FAIL: Binary not found after build"
     exit 1
 fi
 echo "PASS: Binary created successfully"
 
+ln -s "$REPO_DIR/$BINDIR"/router-switch* "$TEST_DIR"/
+cp test-config.json "$TEST_DIR"/
+cat > "$TEST_DIR/config.json" <<'EOF'
+{
+  "providers": {
+    "deepseek": {
+      "description": "DeepSeek",
+      "base_url": "https://api.deepseek.com/anthropic",
+      "api_key": "sk-test-deepseek",
+      "models": ["deepseek-chat", "deepseek-reasoner"]
+    },
+    "glm": {
+      "description": "GLM",
+      "base_url": "https://open.bigmodel.cn/api/anthropic",
+      "api_key": "sk-test-glm",
+      "models": ["glm-4.6"]
+    }
+  }
+}
+EOF
+cd "$TEST_DIR"
+
 # Test 2: Help command
 echo "Test 2: Testing help command..."
 ./router-switch --help > /dev/null
@@ -65,8 +96,9 @@ fi
 
 # Test 6: Error handling - missing provider
 echo "Test 6: Testing error handling for missing provider..."
-./router-switch --provider nonexistent > /tmp/error_output.txt 2>&1
-if [ $? -ne 0 ]; then
+STATUS=0
+./router-switch --provider nonexistent > /tmp/error_output.txt 2>&1 || STATUS=$?
+if [ $STATUS -ne 0 ]; then
     echo "PASS: Error handling works for missing provider"
 else
     echo "FAIL: Should have failed for missing provider"
@@ -75,15 +107,270 @@ fi
 
 # Test 7: Error handling - no provider specified
 echo "Test 7: Testing error handling for no provider..."
-./router-switch > /tmp/no_provider_output.txt 2>&1
-if [ $? -ne 0 ]; then
+STATUS=0
+./router-switch > /tmp/no_provider_output.txt 2>&1 || STATUS=$?
+if [ $STATUS -ne 0 ]; then
     echo "PASS: Error handling works for no provider"
 else
     echo "FAIL: Should have failed for no provider"
     exit 1
 fi
 
+# Test 8: Switch statistics
+echo "Test 8: Testing stats command..."
+./router-switch --provider deepseek > /dev/null 2>&1
+./router-switch stats > /tmp/stats_output.txt 2>&1
+if grep -q "deepseek" /tmp/stats_output.txt; then
+    echo "PASS: Stats command reports recorded switches"
+else
+    echo "FAIL: Stats command did not report the switch"
+    cat /tmp/stats_output.txt
+    exit 1
+fi
+
+# Test 9: Mock server
+echo "Test 9: Testing mock server..."
+./router-switch mock-server -p deepseek --port 18787 2> /tmp/mock_output.txt &
+MOCK_PID=$!
+sleep 0.5
+STATUS=$(curl -s -o /dev/null -w "%{http_code}" -H "x-api-key: sk-test-deepseek" \
+    -d '{"model":"deepseek-chat"}' http://127.0.0.1:18787/anthropic/v1/messages)
+kill -INT $MOCK_PID
+wait $MOCK_PID
+if [ "$STATUS" = "200" ]; then
+    echo "PASS: Mock server answers authenticated requests"
+else
+    echo "FAIL: Mock server returned $STATUS"
+    cat /tmp/mock_output.txt
+    exit 1
+fi
+
+# Test 10: Global switch
+echo "Test 10: Testing global switch..."
+./router-switch --provider deepseek --global > /dev/null 2>&1
+./router-switch sync > /tmp/sync_output.txt 2>&1
+if grep -q "ROUTERSWITCH_CURRENT_PROVIDER=deepseek" /tmp/sync_output.txt && \
+   grep -q "__router_switch_gen=" /tmp/sync_output.txt; then
+    echo "PASS: Sync applies the global switch"
+else
+    echo "FAIL: Sync did not apply the global switch"
+    cat /tmp/sync_output.txt
+    exit 1
+fi
+
+# Test 11: Lite binary
+if [ -x ./router-switch-lite ]; then
+    echo "Test 11: Testing lite binary..."
+    if diff <(ROUTERSWITCH_NO_STATS=1 ./router-switch --provider deepseek) \
+            <(ROUTERSWITCH_NO_STATS=1 ./router-switch-lite --provider deepseek) > /dev/null; then
+        echo "PASS: Lite binary matches the full binary"
+    else
+        echo "FAIL: Lite binary output differs"
+        exit 1
+    fi
+fi
+
+# Test 12: Traffic replay against the mock server
+echo "Test 12: Testing traffic replay..."
+cat > /tmp/replay_config.json <<'EOF'
+{
+  "providers": {
+    "local": {"base_url": "http://127.0.0.1:18788/anthropic", "api_key": "replay-key", "models": ["local-model"]}
+  }
+}
+EOF
+for i in 1 2 3 4 5; do
+    echo "{\"offset_ms\": $((i * 20)), \"body\": {\"model\": \"recorded\", \"stream\": true, \"messages\": []}}"
+done > /tmp/replay_log.jsonl
+./router-switch --config /tmp/replay_config.json mock-server --port 18788 2> /dev/null &
+MOCK_PID=$!
+sleep 0.5
+./router-switch --config /tmp/replay_config.json replay /tmp/replay_log.jsonl > /tmp/replay_output.txt 2>&1
+kill -INT $MOCK_PID
+wait $MOCK_PID
+if grep -qE "^local +local-model +5 +0 " /tmp/replay_output.txt; then
+    echo "PASS: Replay reports all requests as completed"
+else
+    echo "FAIL: Replay did not complete all requests"
+    cat /tmp/replay_output.txt
+    exit 1
+fi
+
+# Test 13: Shared config
+echo "Test 13: Testing shared config..."
+if ./router-switch publish > /tmp/publish_output.txt 2>&1 && \
+   diff <(ROUTERSWITCH_NO_STATS=1 ./router-switch --provider deepseek) \
+        <(ROUTERSWITCH_NO_STATS=1 ./router-switch --shared --provider deepseek) > /dev/null; then
+    echo "PASS: Shared config matches the parsed config"
+else
+    echo "FAIL: Shared config output differs"
+    cat /tmp/publish_output.txt
+    exit 1
+fi
+./router-switch publish --unlink > /dev/null 2>&1
+
+# Test 14: Hedged forwarding to a slow primary and a fast backup
+echo "Test 14: Testing hedged forwarding..."
+cat > /tmp/forward_config.json <<'EOF'
+{
+  "providers": {
+    "slow": {"base_url": "http://127.0.0.1:18791/anthropic", "api_key": "slow-key", "models": ["slow-model"]},
+    "fast": {"base_url": "http://127.0.0.1:18792", "api_key": "fast-key", "models": ["fast-model"]}
+  }
+}
+EOF
+./router-switch --config /tmp/forward_config.json mock-server -p slow --port 18791 --latency-ms 2000 2> /dev/null &
+SLOW_PID=$!
+./router-switch --config /tmp/forward_config.json mock-server -p fast --port 18792 2> /dev/null &
+FAST_PID=$!
+./router-switch --config /tmp/forward_config.json forward --port 18790 --hedge-delay-ms 100 --holdout 0 \
+    2> /tmp/forward_output.txt &
+FORWARD_PID=$!
+sleep 0.5
+curl -s -i -d '{"model":"slow-model","messages":[]}' http://127.0.0.1:18790/v1/messages > /tmp/forward_response.txt
+kill -INT $FORWARD_PID
+wait $FORWARD_PID
+kill -INT $SLOW_PID $FAST_PID
+wait $SLOW_PID $FAST_PID
+if grep -q "x-router-switch-provider: fast" /tmp/forward_response.txt && \
+   grep -q "Mock response from fast" /tmp/forward_response.txt && \
+   grep -q "hedged 1 (100.0%), won by a hedge 1" /tmp/forward_output.txt; then
+    echo "PASS: Hedged request is answered by the faster provider"
+else
+    echo "FAIL: Hedged forwarding did not return the fast response"
+    cat /tmp/forward_response.txt /tmp/forward_output.txt
+    exit 1
+fi
+
+# Test 15: Embedded config
+echo "Test 15: Testing embedded config..."
+if make -C "$REPO_DIR" embed CONFIG="$TEST_DIR/config.json" > /tmp/embed_output.txt 2>&1 && \
+   ln -sf "$REPO_DIR/$BINDIR/router-switch-embedded" . && \
+   diff <(ROUTERSWITCH_NO_STATS=1 ROUTERSWITCH_CURRENT_PROVIDER=deepseek ./router-switch --provider glm) \
+        <(ROUTERSWITCH_NO_STATS=1 ROUTERSWITCH_CURRENT_PROVIDER=deepseek ./router-switch-embedded --provider glm) \
+        > /dev/null; then
+    echo "PASS: Embedded binary matches the parsed config"
+else
+    echo "FAIL: Embedded binary output differs"
+    cat /tmp/embed_output.txt
+    exit 1
+fi
+
+# Test 16: API key pool
+echo "Test 16: Testing API key pool..."
+cat > /tmp/keys_config.json <<'EOF'
+{
+  "providers": {
+    "pool": {"base_url": "https://pool.example.com", "api_keys": ["key-0", "key-1", "key-2"]},
+    "weighted": {"base_url": "https://weighted.example.com", "api_keys": ["key-0", "key-1", "key-2"],
+                 "key_policy": "weighted", "key_weights": [0, 3, 1]},
+    "lru": {"base_url": "https://lru.example.com", "api_keys": ["key-0", "key-1"], "key_policy": "lru"}
+  }
+}
+EOF
+./router-switch --config /tmp/keys_config.json cooldown -p pool --key 0 --seconds 60 > /dev/null
+for i in 1 2 3 4 5 6; do
+    ./router-switch --config /tmp/keys_config.json --provider pool
+    ./router-switch --config /tmp/keys_config.json --provider weighted
+done | grep "ANTHROPIC_AUTH_TOKEN" > /tmp/keys_output.txt
+# Without a usable state directory keys are picked by process id
+for i in 1 2 3 4 5 6; do
+    ROUTERSWITCH_STATE_DIR=/dev/null ./router-switch --config /tmp/keys_config.json --provider weighted
+done | grep "ANTHROPIC_AUTH_TOKEN" >> /tmp/keys_output.txt
+./router-switch --config /tmp/keys_config.json --provider lru | grep "ANTHROPIC_AUTH_TOKEN" > /tmp/lru_output.txt
+./router-switch --config /tmp/keys_config.json --provider lru | grep "ANTHROPIC_AUTH_TOKEN" >> /tmp/lru_output.txt
+if ! grep -q "key-0" /tmp/keys_output.txt && grep -q "key-1" /tmp/keys_output.txt && \
+   grep -q "key-2" /tmp/keys_output.txt && [ "$(sort -u /tmp/lru_output.txt | wc -l)" -eq 2 ] && \
+   ! ./router-switch --config /tmp/keys_config.json cooldown -p pool --key abc > /dev/null 2>&1 && \
+   ! ./router-switch --config /tmp/keys_config.json cooldown -p pool --key -1 > /dev/null 2>&1 && \
+   ! ./router-switch --config /tmp/keys_config.json cooldown -p pool --key 3 > /dev/null 2>&1 && \
+   ! ./router-switch --config /tmp/keys_config.json cooldown -p pool --key 1 --seconds 0 > /dev/null 2>&1 && \
+   ! ./router-switch --config <(sed 's/"lru"}/"fifo"}/' /tmp/keys_config.json) --provider pool > /dev/null 2>&1 && \
+   ! ./router-switch --config <(sed 's/\[0, 3, 1\]/[0, -1, 1]/' /tmp/keys_config.json) --provider pool > /dev/null 2>&1; then
+    echo "PASS: Key pool honors policies, weights and cooldowns"
+else
+    echo "FAIL: Key pool selection or validation is wrong"
+    cat /tmp/keys_output.txt /tmp/lru_output.txt
+    exit 1
+fi
+
+# Test 17: Mock server under many concurrent connections
+echo "Test 17: Testing mock server concurrency..."
+if [ "$(ulimit -Hn)" != "unlimited" ] && [ "$(ulimit -Hn)" -lt 4200 ]; then
+    echo "SKIP: Mock server concurrency test (descriptor limit below 4200)"
+else
+    cat > /tmp/concurrency_config.json <<'EOF'
+{
+  "providers": {
+    "local": {"base_url": "http://127.0.0.1:18789/anthropic", "api_key": "load-key", "models": ["local-model"]}
+  }
+}
+EOF
+    for i in $(seq 1 4000); do
+        echo '{"offset_ms": 0, "body": {"model": "local-model", "messages": []}}'
+    done > /tmp/concurrency_log.jsonl
+    ./router-switch --config /tmp/concurrency_config.json mock-server --port 18789 --latency-ms 1000 \
+        2> /tmp/mock_output.txt &
+    MOCK_PID=$!
+    sleep 0.5
+    ./router-switch --config /tmp/concurrency_config.json replay /tmp/concurrency_log.jsonl \
+        > /tmp/replay_output.txt 2>&1
+    kill -INT $MOCK_PID
+    wait $MOCK_PID
+    if grep -qE "^local +local-model +4000 +0 " /tmp/replay_output.txt && \
+       grep -q "peak 4000 concurrent connections" /tmp/mock_output.txt; then
+        echo "PASS: Mock server holds 4000 concurrent connections"
+    else
+        echo "FAIL: Mock server did not serve 4000 concurrent requests"
+        cat /tmp/replay_output.txt /tmp/mock_output.txt
+        exit 1
+    fi
+fi
+
+# Test 18: Lite binary rejects an invalid key pool in another provider
+if [ -x ./router-switch-lite ]; then
+    echo "Test 18: Testing lite validation of other providers..."
+    cat > /tmp/lite_config.json <<'EOF'
+{
+  "providers": {
+    "good": {"base_url": "https://good.example.com", "api_key": "good-key", "models": ["good-model"]},
+    "broken": {"base_url": "https://broken.example.com", "api_keys": ["a", "b"], "key_weights": [0, 0]}
+  }
+}
+EOF
+    FULL_STATUS=0
+    ./router-switch --config /tmp/lite_config.json --provider good > /dev/null 2>&1 || FULL_STATUS=$?
+    LITE_STATUS=0
+    ./router-switch-lite --config /tmp/lite_config.json --provider good > /dev/null 2>&1 || LITE_STATUS=$?
+    if [ "$FULL_STATUS" -eq 1 ] && [ "$LITE_STATUS" -eq 1 ]; then
+        echo "PASS: Lite binary rejects the same config as the full binary"
+    else
+        echo "FAIL: Full binary exited $FULL_STATUS, lite binary exited $LITE_STATUS"
+        exit 1
+    fi
+fi
+
+# Test 19: Numeric options and provider lists of the network commands are validated
+echo "Test 19: Testing network command option validation..."
+TOO_MANY=$(for i in $(seq 11); do printf -- "-p provider%d " "$i"; done)
+if ! ./router-switch mock-server --port abc > /dev/null 2>&1 && \
+   ! ./router-switch mock-server --error-rate 5 > /dev/null 2>&1 && \
+   ! ./router-switch mock-server $TOO_MANY > /dev/null 2>&1 && \
+   ! ./router-switch replay --timeout-ms 10x /dev/null > /dev/null 2>&1 && \
+   ! ./router-switch replay --speed 0 /dev/null > /dev/null 2>&1 && \
+   ! ./router-switch forward --port 70000 > /dev/null 2>&1 && \
+   ! ./router-switch forward --hedge-percentile abc > /dev/null 2>&1; then
+    echo "PASS: Invalid option values and extra providers are rejected"
+else
+    echo "FAIL: An invalid option value was accepted"
+    exit 1
+fi
+
 # Cleanup
-rm -f /tmp/test_output.txt /tmp/error_output.txt /tmp/no_provider_output.txt
+rm -f /tmp/mock_output.txt  /tmp/test_output.txt /tmp/error_output.txt /tmp/no_provider_output.txt /tmp/stats_output.txt /tmp/sync_output.txt \
+    /tmp/publish_output.txt /tmp/embed_output.txt /tmp/keys_config.json /tmp/keys_output.txt /tmp/lru_output.txt \
+    /tmp/concurrency_config.json /tmp/concurrency_log.jsonl /tmp/lite_config.json \
+    /tmp/replay_config.json /tmp/replay_log.jsonl /tmp/replay_output.txt \
+    /tmp/forward_config.json /tmp/forward_output.txt /tmp/forward_response.txt
 
 echo "All tests passed! ✅"
\ No newline at end of file
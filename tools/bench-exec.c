@@ -0,0 +1,117 @@
+// Exec-to-exit benchmark used by `make bench`. Runs a command repeatedly
+// (stdout to /dev/null), timing fork to reap and reading the peak RSS and
+// CPU time of each child from wait4, and prints one summary line per command.
+// With -c N each round starts N copies at once, to measure cold starts that
+// contend with each other.
+
+#define _DEFAULT_SOURCE
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+static double now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int count, double pct) {
+    int index = (int)(pct / 100.0 * (count - 1) + 0.5);
+    return sorted[index];
+}
+
+int main(int argc, char *argv[]) {
+    int runs = 500;
+    int warmup = 20;
+    int concurrency = 1;
+    const char *label = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "+n:w:c:l:")) != -1) {
+        switch (opt) {
+            case 'n': runs = atoi(optarg); break;
+            case 'w': warmup = atoi(optarg); break;
+            case 'c': concurrency = atoi(optarg); break;
+            case 'l': label = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-n runs] [-w warmup] [-c concurrency] [-l label] command [args...]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (optind >= argc || runs < 1 || warmup < 0 || concurrency < 1) {
+        fprintf(stderr, "Usage: %s [-n runs] [-w warmup] [-c concurrency] [-l label] command [args...]\n", argv[0]);
+        return 1;
+    }
+    if (!label) label = argv[optind];
+
+    // Each round contributes one sample per concurrent child
+    int count = runs * concurrency;
+    double *samples = malloc(sizeof(double) * (size_t)count);
+    if (!samples) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        return 1;
+    }
+
+    long max_rss = 0;
+    double total_cpu = 0;
+    int failures = 0;
+    for (int i = -warmup; i < runs; i++) {
+        double start = now_us();
+        for (int j = 0; j < concurrency; j++) {
+            pid_t pid = fork();
+            if (pid < 0) {
+                perror("fork");
+                return 1;
+            }
+            if (pid == 0) {
+                int null_fd = open("/dev/null", O_WRONLY);
+                if (null_fd >= 0) dup2(null_fd, STDOUT_FILENO);
+                execv(argv[optind], argv + optind);
+                _exit(127);
+            }
+        }
+
+        for (int j = 0; j < concurrency; j++) {
+            int status;
+            struct rusage usage;
+            if (wait4(-1, &status, 0, &usage) < 0) {
+                perror("wait4");
+                return 1;
+            }
+            double elapsed = now_us() - start;
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failures++;
+            if (i < 0) continue;
+
+            samples[i * concurrency + j] = elapsed;
+            total_cpu += (double)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e6 +
+                         (double)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+#ifdef __APPLE__
+            usage.ru_maxrss /= 1024; // bytes on macOS
+#endif
+            if (usage.ru_maxrss > max_rss) max_rss = usage.ru_maxrss;
+        }
+    }
+
+    qsort(samples, (size_t)count, sizeof(double), compare_double);
+    double total = 0;
+    for (int i = 0; i < count; i++) total += samples[i];
+
+    printf("%-24s %6d %9.0f %9.0f %9.0f %9.0f %9.0f %9ld%s\n", label, count,
+           percentile(samples, count, 50), percentile(samples, count, 90),
+           percentile(samples, count, 99), total / count, total_cpu / count, max_rss,
+           failures ? "  (non-zero exits)" : "");
+    free(samples);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,217 @@
+// Build-time generator for embedded configuration (`make embed CONFIG=path`).
+// Parses a config.json with the regular parser and emits a C source file of
+// static const provider tables, a perfect-hash index over provider names and
+// pre-escaped export strings, so the resulting binary switches without any
+// file I/O or parsing.
+
+#include "router-switch.h"
+
+#define MAX_SCRIPT_LENGTH 16384
+#define MAX_HASH_SEED_ATTEMPTS 1000000
+
+static const char *policy_names[] = {
+    "KEY_POLICY_ROUND_ROBIN",
+    "KEY_POLICY_LEAST_RECENTLY_USED",
+    "KEY_POLICY_WEIGHTED"
+};
+
+// Append "export NAME=<escaped value>\n" to a script buffer
+static void append_export(char *script, const char *name, const char *value) {
+    char *escaped = shell_escape(value);
+    if (!escaped) {
+        fprintf(stderr, "Failed to allocate memory\n");
+        exit(1);
+    }
+    size_t used = strlen(script);
+    snprintf(script + used, MAX_SCRIPT_LENGTH - used, "export %s=%s\n", name, escaped);
+    free(escaped);
+}
+
+static void append_unset(char *script, const char *name) {
+    size_t used = strlen(script);
+    snprintf(script + used, MAX_SCRIPT_LENGTH - used, "unset %s\n", name);
+}
+
+// Write a C string literal, escaping everything outside printable ASCII
+static void emit_string(FILE *out, const char *value) {
+    fputc('"', out);
+    for (const unsigned char *p = (const unsigned char *)value; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fprintf(out, "\\%c", *p);
+        } else if (*p == '\n') {
+            fputs("\\n", out);
+        } else if (*p < 0x20 || *p >= 0x7f || *p == '?') {
+            fprintf(out, "\\%03o", *p);
+        } else {
+            fputc(*p, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static void emit_string_array(FILE *out, const char *name, int index, const char *rows, size_t row_size, int count) {
+    fprintf(out, "static const char *const %s_%d[] = {", name, index);
+    for (int i = 0; i < count; i++) {
+        fputs(i > 0 ? ", " : "", out);
+        emit_string(out, rows + (size_t)i * row_size);
+    }
+    fprintf(out, "%s};\n", count == 0 ? "0" : "");
+}
+
+// Find a seed that maps every provider name to a distinct slot
+static uint32_t find_hash_seed(const Config *config, uint32_t index_size, int16_t *index) {
+    for (uint32_t seed = 0; seed < MAX_HASH_SEED_ATTEMPTS; seed++) {
+        int collision = 0;
+        for (uint32_t slot = 0; slot < index_size; slot++) index[slot] = -1;
+
+        for (int i = 0; i < config->provider_count && !collision; i++) {
+            uint32_t slot = hash_provider_name(config->providers[i].name, seed) & (index_size - 1);
+            if (index[slot] >= 0) collision = 1;
+            else index[slot] = (int16_t)i;
+        }
+        if (!collision) return seed;
+    }
+    fprintf(stderr, "Failed to find a perfect hash for the provider names\n");
+    exit(1);
+}
+
+static void emit_provider_tables(FILE *out, const ProviderConfig *provider, int index) {
+    char script[MAX_SCRIPT_LENGTH];
+
+    emit_string_array(out, "api_keys", index, provider->api_keys[0], sizeof(provider->api_keys[0]), provider->api_key_count);
+    emit_string_array(out, "models", index, provider->models[0], MAX_MODEL_NAME, provider->model_count);
+    emit_string_array(out, "env_names", index, provider->env_names[0], MAX_ENV_VAR_NAME, provider->env_count);
+    emit_string_array(out, "env_values", index, provider->env_values[0], MAX_ENV_VAR_VALUE, provider->env_count);
+
+    fprintf(out, "static const int key_weights_%d[] = {", index);
+    for (int i = 0; i < MAX_API_KEYS; i++) {
+        fprintf(out, "%s%d", i > 0 ? ", " : "", provider->key_weights[i]);
+    }
+    fprintf(out, "};\n");
+
+    fprintf(out, "static const char *const api_key_exports_%d[] = {", index);
+    for (int i = 0; i < provider->api_key_count; i++) {
+        script[0] = '\0';
+        append_export(script, "ANTHROPIC_AUTH_TOKEN", provider->api_keys[i]);
+        fputs(i > 0 ? ", " : "", out);
+        emit_string(out, script);
+    }
+    fprintf(out, "%s};\n", provider->api_key_count == 0 ? "0" : "");
+
+    fprintf(out, "static const char *const model_exports_%d[] = {", index);
+    for (int i = 0; i < provider->model_count; i++) {
+        script[0] = '\0';
+        append_export(script, "ANTHROPIC_MODEL", provider->models[i]);
+        fputs(i > 0 ? ", " : "", out);
+        emit_string(out, script);
+    }
+    fprintf(out, "%s};\n\n", provider->model_count == 0 ? "0" : "");
+}
+
+static void emit_provider_entry(FILE *out, const ProviderConfig *provider, int index) {
+    char script[MAX_SCRIPT_LENGTH];
+
+    fprintf(out, "    {\n        ");
+    emit_string(out, provider->name);
+    fprintf(out, ",\n        ");
+    emit_string(out, provider->description);
+    fprintf(out, ",\n        ");
+    emit_string(out, provider->base_url);
+    fprintf(out, ",\n        ");
+    emit_string(out, provider->api_key);
+    fprintf(out, ",\n        api_keys_%d, key_weights_%d, %d, %s,\n", index, index,
+            provider->api_key_count, policy_names[provider->key_policy]);
+    fprintf(out, "        models_%d, %d,\n", index, provider->model_count);
+    fprintf(out, "        env_names_%d, env_values_%d, %d,\n        ", index, index, provider->env_count);
+
+    // Same sequence as clear_provider_environment
+    script[0] = '\0';
+    append_unset(script, "ANTHROPIC_BASE_URL");
+    append_unset(script, "ANTHROPIC_AUTH_TOKEN");
+    append_unset(script, "ANTHROPIC_MODEL");
+    for (int i = 0; i < provider->env_count; i++) {
+        append_unset(script, provider->env_names[i]);
+    }
+    append_unset(script, "ROUTERSWITCH_CURRENT_PROVIDER");
+    emit_string(out, script);
+    fprintf(out, ",\n        ");
+
+    script[0] = '\0';
+    append_export(script, "ANTHROPIC_BASE_URL", provider->base_url);
+    emit_string(out, script);
+    fprintf(out, ",\n        ");
+
+    script[0] = '\0';
+    append_export(script, "ANTHROPIC_AUTH_TOKEN", provider->api_key);
+    emit_string(out, script);
+    fprintf(out, ",\n        api_key_exports_%d, model_exports_%d,\n        ", index, index);
+
+    // Same sequence as the tail of apply_provider_environment
+    script[0] = '\0';
+    for (int i = 0; i < provider->env_count; i++) {
+        append_export(script, provider->env_names[i], provider->env_values[i]);
+    }
+    append_export(script, "ROUTERSWITCH_CURRENT_PROVIDER", provider->name);
+    emit_string(out, script);
+    fprintf(out, "\n    },\n");
+}
+
+int main(int argc, char *argv[]) {
+    Config config;
+
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <config.json> <output.c>\n", argv[0]);
+        return 1;
+    }
+
+    if (!load_config(argv[1], &config)) {
+        return 1;
+    }
+
+    uint32_t index_size = 1;
+    while (index_size < (uint32_t)config.provider_count * 2) index_size <<= 1;
+    int16_t index[MAX_PROVIDERS * 4];
+    uint32_t seed = find_hash_seed(&config, index_size, index);
+
+    FILE *out = fopen(argv[2], "w");
+    if (!out) {
+        fprintf(stderr, "Failed to open output file '%s'\n", argv[2]);
+        return 1;
+    }
+
+    fprintf(out, "// Generated by tools/embed-config.c from %s - do not edit\n\n", argv[1]);
+    fprintf(out, "#include \"router-switch.h\"\n\n");
+
+    for (int i = 0; i < config.provider_count; i++) {
+        emit_provider_tables(out, &config.providers[i], i);
+    }
+
+    fprintf(out, "static const EmbeddedProvider providers[] = {\n");
+    for (int i = 0; i < config.provider_count; i++) {
+        emit_provider_entry(out, &config.providers[i], i);
+    }
+    if (config.provider_count == 0) {
+        fprintf(out, "    {0}\n");
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "static const int16_t provider_index[] = {");
+    for (uint32_t slot = 0; slot < index_size; slot++) {
+        fprintf(out, "%s%d", slot > 0 ? ", " : "", index[slot]);
+    }
+    fprintf(out, "};\n\n");
+
+    fprintf(out, "const EmbeddedConfig embedded_config = {\n");
+    fprintf(out, "    providers, %d, provider_index, %u, %uu, ", config.provider_count, index_size, seed);
+    emit_string(out, argv[1]);
+    fprintf(out, "\n};\n");
+
+    if (fclose(out) != 0) {
+        fprintf(stderr, "Failed to write output file '%s'\n", argv[2]);
+        return 1;
+    }
+
+    fprintf(stderr, "Embedded %d providers from '%s' (hash seed %u, %u slots)\n",
+            config.provider_count, argv[1], seed, index_size);
+    return 0;
+}